@@ -0,0 +1,125 @@
+#version 430 core
+// Проход освещения отложенного пути: один полноэкранный треугольник, на каждый
+// пиксель G-буфера (см. gbuffer.h) - направленные источники и список кластера,
+// как в f_lighting.glsl. Специализация - NUM_DIRECTIONAL_LIGHTS.
+
+out vec4 FragColor;
+
+layout(binding = 0) uniform sampler2D gAlbedo;
+layout(binding = 1) uniform sampler2D gNormal;
+layout(binding = 2) uniform usampler2D gMaterial;
+layout(binding = 3) uniform sampler2D gDepth;
+
+// Раскладка std430 совпадает с GpuMaterial в material.h
+struct Material {
+    vec3 diffuseColor;
+    float shininess;
+    vec3 specularColor;
+    float padding0;
+    vec3 emissionColor;
+    float padding1;
+    vec3 ambientColor;
+    float padding2;
+};
+
+layout(std430) readonly buffer MaterialBuffer {
+    Material materials[];
+};
+
+// Раскладка std430 совпадает с GpuLight в light.h
+struct Light {
+    vec3 position;
+    int type;             // 0 - point, 1 - directional, 2 - spot
+    vec3 direction;
+    float cutOff;
+    vec3 color;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding;
+};
+
+layout(std430) readonly buffer LightBuffer {
+    int directionalCount;
+    int pointCount;
+    int spotCount;
+    Light lights[];
+};
+
+#ifndef NUM_DIRECTIONAL_LIGHTS
+#define NUM_DIRECTIONAL_LIGHTS directionalCount
+#endif
+
+// См. light_clusters.h
+layout(std430) readonly buffer LightClusterBuffer {
+    uvec4 clusterGrid;
+    vec4 clusterScale;
+    uint clusterData[];
+};
+
+// Данные кадра, общие для всех программ (см. frame_data.h)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+vec3 shade(Light light, vec3 lightDir, vec3 norm, vec3 viewDir, Material material) {
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float diff = max(dot(norm, lightDir), 0.0);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = spec * light.color * material.specularColor;
+    return light.intensity * (diff * material.diffuseColor + specular);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depthSample = texelFetch(gDepth, pixel, 0).r;
+    // Фон: геометрии здесь не было, остаётся цвет очистки
+    if (depthSample == 1.0) discard;
+
+    // Позиция из глубины: сначала в пространстве вида по проекции, затем обратно в мир
+    // (у view нет масштаба, обратная - транспонированный поворот)
+    vec2 ndc = (vec2(pixel) + 0.5) / vec2(textureSize(gDepth, 0)) * 2.0 - 1.0;
+    float viewZ = -projection[3][2] / (depthSample * 2.0 - 1.0 + projection[2][2]);
+    vec3 viewSpace = vec3(ndc.x * -viewZ / projection[0][0], ndc.y * -viewZ / projection[1][1], viewZ);
+    vec3 FragPos = transpose(mat3(view)) * (viewSpace - view[3].xyz);
+
+    Material material = materials[texelFetch(gMaterial, pixel, 0).r];
+    vec3 norm = texelFetch(gNormal, pixel, 0).xyz;
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
+    vec3 result = material.ambientColor;
+
+    for (int i = 0; i < NUM_DIRECTIONAL_LIGHTS; ++i) {
+        Light light = lights[i];
+        result += shade(light, normalize(-light.direction), norm, viewDir, material);
+    }
+
+    int slice = int(log(max(-viewZ, 1e-4)) * clusterScale.z + clusterScale.w);
+    ivec3 cell = clamp(ivec3(ivec2(gl_FragCoord.xy * clusterScale.xy), slice), ivec3(0), ivec3(clusterGrid.xyz) - 1);
+    uint cluster = uint(cell.x) + clusterGrid.x * (uint(cell.y) + clusterGrid.y * uint(cell.z));
+    uint first = clusterData[2u * cluster];
+    uint last = first + clusterData[2u * cluster + 1u];
+
+    for (uint i = first; i < last; ++i) {
+        Light light = lights[clusterData[i]];
+        vec3 toLight = light.position - FragPos;
+        float distance = length(toLight);
+        vec3 lightDir = toLight / distance;
+        if (light.type == 2) {
+            float theta = dot(lightDir, normalize(-light.direction));
+            if (theta < light.cutOff) continue;
+            result += shade(light, lightDir, norm, viewDir, material);
+        }
+        else {
+            float attenuation = light.intensity / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+            result += attenuation * shade(light, lightDir, norm, viewDir, material);
+        }
+    }
+
+    result += material.emissionColor;
+    result *= texelFetch(gAlbedo, pixel, 0).rgb;
+
+    FragColor = vec4(result, 1.0);
+}
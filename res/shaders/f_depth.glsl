@@ -0,0 +1,5 @@
+#version 430 core
+// Проход глубины пишет только глубину
+
+void main() {
+}
@@ -0,0 +1,24 @@
+#version 430 core
+// Проход геометрии отложенного освещения: пишет G-буфер (см. gbuffer.h).
+// Из define специализации учитывается только NO_TEXTURE.
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+flat in int MaterialIndex;
+
+layout(location = 0) out vec4 gAlbedo;
+layout(location = 1) out vec4 gNormal;
+layout(location = 2) out uint gMaterial;
+
+uniform sampler2D texture1;
+
+void main() {
+#ifndef NO_TEXTURE
+    gAlbedo = vec4(texture(texture1, TexCoord).rgb, 1.0);
+#else
+    gAlbedo = vec4(1.0);
+#endif
+    gNormal = vec4(normalize(Normal), 0.0);
+    gMaterial = uint(MaterialIndex);
+}
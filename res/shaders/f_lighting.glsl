@@ -1,73 +1,128 @@
-#version 330 core
-#define MAX_LIGHTS 10
+#version 430 core
+// Специализация (см. shader_permutation.h) задаётся #define после #version:
+//   NUM_DIRECTIONAL_LIGHTS - число направленных источников
+//   NO_TEXTURE - без выборки из текстуры, NO_EMISSION - без эмиссии материала
+// Без них шейдер общий: число источников читается из буфера.
 
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoord;
+flat in int MaterialIndex;
 
 out vec4 FragColor;
 
 uniform sampler2D texture1;
 
-uniform struct Material {
+// Раскладка std430 совпадает с GpuMaterial в material.h
+struct Material {
     vec3 diffuseColor;    // Диффузный цвет материала
+    float shininess;      // Степень блеска материала
     vec3 specularColor;   // Цвет бликов материала
+    float padding0;
     vec3 emissionColor;   // Цвет эмиссии материала
+    float padding1;
     vec3 ambientColor;    // Цвет амбиентной составляющей материала
-    float shininess;      // Степень блеска материала
-} material;
+    float padding2;
+};
+
+layout(std430) readonly buffer MaterialBuffer {
+    Material materials[];
+};
 
+// Раскладка std430 совпадает с GpuLight в light.h
 struct Light {
-    int type; // 0 - point, 1 - directional, 2 - spot
-    vec3 position;       // Позиция света
+    vec3 position;        // Позиция света
+    int type;             // 0 - point, 1 - directional, 2 - spot
     vec3 direction;       // Направление света
+    float cutOff;
     vec3 color;           // Цвет света
     float intensity;      // Интенсивность света
     float constant;
     float linear;
     float quadratic;
-    float cutOff;
+    float padding;
+};
+
+// Источники отсортированы по типу: направленные, точечные, прожекторы.
+// Направленные обходятся все, остальные - только из списка кластера фрагмента
+layout(std430) readonly buffer LightBuffer {
+    int directionalCount;
+    int pointCount;
+    int spotCount;
+    Light lights[];
 };
 
-uniform Light lights[MAX_LIGHTS];
+#ifndef NUM_DIRECTIONAL_LIGHTS
+#define NUM_DIRECTIONAL_LIGHTS directionalCount
+#endif
 
-uniform vec3 ViewPos;
-uniform int numLights;
+// Списки источников по кластерам (см. light_clusters.h): clusterData начинается
+// с пар (начало, число) для каждого кластера, дальше идут индексы в lights[]
+layout(std430) readonly buffer LightClusterBuffer {
+    uvec4 clusterGrid;    // Число кластеров по x, y, z
+    vec4 clusterScale;    // Тайлов на пиксель по x и y, масштаб и сдвиг log(глубины) для среза
+    uint clusterData[];
+};
+
+// Данные кадра, общие для всех программ (см. frame_data.h)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+vec3 shade(Light light, vec3 lightDir, vec3 norm, vec3 viewDir, Material material) {
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float diff = max(dot(norm, lightDir), 0.0);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 specular = spec * light.color * material.specularColor;
+    return light.intensity * (diff * material.diffuseColor + specular);
+}
 
 void main() {
+    Material material = materials[MaterialIndex];
     vec3 norm = normalize(Normal);
-    vec3 viewDir = normalize(ViewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 result = material.ambientColor;
 
-    for (int i = 0; i < numLights; ++i) {
-        vec3 local_result = vec3(0,0,0);
-        vec3 lightDir = normalize(lights[i].position - FragPos);
-        if (lights[i].type == 1) lightDir = normalize(-lights[i].direction);
-        if (lights[i].type == 2) {
-            float theta = dot(lightDir, normalize(-lights[i].direction));
-            if (theta < lights[i].cutOff) continue;
-        }
-
-        vec3 reflectDir = reflect(-lightDir, norm);
-        float diff = max(dot(norm, lightDir), 0.0);
-        vec3 specular = vec3(0.0);
+    for (int i = 0; i < NUM_DIRECTIONAL_LIGHTS; ++i) {
+        Light light = lights[i];
+        result += shade(light, normalize(-light.direction), norm, viewDir, material);
+    }
 
-        float distance = length(lights[i].position - FragPos);
-        float attenuation = 1.0 / (lights[i].constant + lights[i].linear * distance + lights[i].quadratic * (distance * distance));
-        attenuation *= lights[i].intensity;
+    // Кластер: тайл экрана по gl_FragCoord и экспоненциальный срез по глубине в пространстве вида
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    int slice = int(log(max(depth, 1e-4)) * clusterScale.z + clusterScale.w);
+    ivec3 cell = clamp(ivec3(ivec2(gl_FragCoord.xy * clusterScale.xy), slice), ivec3(0), ivec3(clusterGrid.xyz) - 1);
+    uint cluster = uint(cell.x) + clusterGrid.x * (uint(cell.y) + clusterGrid.y * uint(cell.z));
+    uint first = clusterData[2u * cluster];
+    uint last = first + clusterData[2u * cluster + 1u];
 
-        float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-        specular = spec * lights[i].color * material.specularColor;
-        local_result = lights[i].intensity * (diff * material.diffuseColor + specular);
-        if (lights[i].type == 0) local_result *= attenuation;
-        result += local_result;
+    for (uint i = first; i < last; ++i) {
+        Light light = lights[clusterData[i]];
+        vec3 toLight = light.position - FragPos;
+        float distance = length(toLight);
+        vec3 lightDir = toLight / distance;
+        if (light.type == 2) {
+            float theta = dot(lightDir, normalize(-light.direction));
+            if (theta < light.cutOff) continue;
+            result += shade(light, lightDir, norm, viewDir, material);
+        }
+        else {
+            float attenuation = light.intensity / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+            result += attenuation * shade(light, lightDir, norm, viewDir, material);
+        }
     }
 
+#ifndef NO_EMISSION
     result += material.emissionColor;
+#endif
 
+#ifndef NO_TEXTURE
     // Добавление текстуры
     vec4 textureColor = texture(texture1, TexCoord);
     result *= textureColor.rgb;
+#endif
 
     FragColor = vec4(result, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,23 @@
+#version 430 core
+// Проход глубины: только позиция и матрица модели (поток позиций GeometryPool).
+// Глубина должна совпасть с v_lighting.glsl бит в бит - основной проход сравнивает
+// её через GL_EQUAL, поэтому выражение то же и gl_Position объявлен invariant.
+
+layout(location = 0) in vec3 inPosition;
+
+// Атрибуты экземпляра (см. instance_data.h)
+layout(location = 3) in mat4 instanceModel;
+
+// Данные кадра, общие для всех программ (см. frame_data.h)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+invariant gl_Position;
+
+void main() {
+    vec3 worldPos = vec3(instanceModel * vec4(inPosition, 1.0));
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -1,21 +1,35 @@
-#version 330 core
+#version 430 core
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
 
+// Атрибуты экземпляра (см. instance_data.h)
+layout(location = 3) in mat4 instanceModel;
+// Обратная транспонированная к model, считается на CPU один раз на объект
+layout(location = 7) in mat3 instanceNormalMatrix;
+layout(location = 10) in int instanceMaterial;
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
+flat out int MaterialIndex;
+
+// Данные кадра, общие для всех программ (см. frame_data.h)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Та же глубина, что в v_depth.glsl, - для прохода с GL_EQUAL после предварительного
+invariant gl_Position;
 
 void main() {
-    FragPos = vec3(model * vec4(inPosition, 1.0));
-    Normal = mat3(transpose(inverse(model))) * inNormal;
+    FragPos = vec3(instanceModel * vec4(inPosition, 1.0));
+    Normal = instanceNormalMatrix * inNormal;
     TexCoord = inTexCoord;
+    MaterialIndex = instanceMaterial;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
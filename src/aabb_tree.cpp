@@ -0,0 +1,233 @@
+#include "aabb_tree.h"
+#include <algorithm>
+#include <cassert>
+
+static Aabb combine(const Aabb& a, const Aabb& b) {
+    Aabb result = a;
+    result.expand(b);
+    return result;
+}
+
+int32_t AabbTree::createProxy(const Aabb& box, void* userData) {
+    const int32_t proxy = allocateNode();
+    Node& node = mNodes[proxy];
+    node.box = { box.min - glm::vec3(MARGIN), box.max + glm::vec3(MARGIN) };
+    node.userData = userData;
+    node.height = 0;
+
+    insertLeaf(proxy);
+    ++mProxyCount;
+    return proxy;
+}
+
+void AabbTree::destroyProxy(int32_t proxy) {
+    assert(proxy >= 0 && proxy < static_cast<int32_t>(mNodes.size()) && mNodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --mProxyCount;
+}
+
+bool AabbTree::moveProxy(int32_t proxy, const Aabb& box, const glm::vec3& displacement) {
+    assert(proxy >= 0 && proxy < static_cast<int32_t>(mNodes.size()) && mNodes[proxy].isLeaf());
+    if (mNodes[proxy].box.contains(box)) return false;
+
+    // Новый толстый AABB вытянут по направлению движения: следующие кадры
+    // скорее всего уложатся в него без перестановки
+    Aabb fat = { box.min - glm::vec3(MARGIN), box.max + glm::vec3(MARGIN) };
+    const glm::vec3 predicted = displacement * DISPLACEMENT_MULTIPLIER;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (predicted[axis] < 0.0f) fat.min[axis] += predicted[axis];
+        else fat.max[axis] += predicted[axis];
+    }
+
+    removeLeaf(proxy);
+    mNodes[proxy].box = fat;
+    insertLeaf(proxy);
+    return true;
+}
+
+void* AabbTree::userData(int32_t proxy) const {
+    return mNodes[proxy].userData;
+}
+
+const Aabb& AabbTree::fatAabb(int32_t proxy) const {
+    return mNodes[proxy].box;
+}
+
+int32_t AabbTree::height() const {
+    return mRoot == NULL_NODE ? 0 : mNodes[mRoot].height;
+}
+
+size_t AabbTree::size() const {
+    return mProxyCount;
+}
+
+void AabbTree::clear() {
+    mNodes.clear();
+    mRoot = NULL_NODE;
+    mFreeList = NULL_NODE;
+    mProxyCount = 0;
+}
+
+int32_t AabbTree::allocateNode() {
+    if (mFreeList == NULL_NODE) {
+        mNodes.emplace_back();
+        return static_cast<int32_t>(mNodes.size() - 1);
+    }
+    const int32_t node = mFreeList;
+    mFreeList = mNodes[node].parent;
+    mNodes[node] = Node();
+    return node;
+}
+
+void AabbTree::freeNode(int32_t node) {
+    mNodes[node].parent = mFreeList;
+    mNodes[node].height = -1;
+    mNodes[node].userData = nullptr;
+    mFreeList = node;
+}
+
+void AabbTree::insertLeaf(int32_t leaf) {
+    if (mRoot == NULL_NODE) {
+        mRoot = leaf;
+        mNodes[leaf].parent = NULL_NODE;
+        return;
+    }
+
+    // Спуск к соседу с наименьшим приростом суммарной площади поверхности
+    const Aabb leafBox = mNodes[leaf].box;
+    int32_t index = mRoot;
+    while (!mNodes[index].isLeaf()) {
+        const Node& node = mNodes[index];
+        const float area = node.box.surfaceArea();
+        const float combinedArea = combine(node.box, leafBox).surfaceArea();
+
+        // Цена нового родителя на месте этого узла и цена, унаследованная потомками
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child) {
+            const Node& childNode = mNodes[child];
+            const float grown = combine(childNode.box, leafBox).surfaceArea();
+            if (childNode.isLeaf()) return grown + inheritanceCost;
+            return grown - childNode.box.surfaceArea() + inheritanceCost;
+        };
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = mNodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    mNodes[newParent].parent = oldParent;
+    mNodes[newParent].box = combine(leafBox, mNodes[sibling].box);
+    mNodes[newParent].height = mNodes[sibling].height + 1;
+    mNodes[newParent].child1 = sibling;
+    mNodes[newParent].child2 = leaf;
+    mNodes[sibling].parent = newParent;
+    mNodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE) {
+        mRoot = newParent;
+    }
+    else if (mNodes[oldParent].child1 == sibling) {
+        mNodes[oldParent].child1 = newParent;
+    }
+    else {
+        mNodes[oldParent].child2 = newParent;
+    }
+
+    refit(mNodes[leaf].parent);
+}
+
+void AabbTree::removeLeaf(int32_t leaf) {
+    if (leaf == mRoot) {
+        mRoot = NULL_NODE;
+        return;
+    }
+
+    // Родитель листа уходит, его место занимает брат
+    const int32_t parent = mNodes[leaf].parent;
+    const int32_t grandParent = mNodes[parent].parent;
+    const int32_t sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+    if (grandParent == NULL_NODE) {
+        mRoot = sibling;
+        mNodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    if (mNodes[grandParent].child1 == parent) mNodes[grandParent].child1 = sibling;
+    else mNodes[grandParent].child2 = sibling;
+    mNodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refit(grandParent);
+}
+
+void AabbTree::refit(int32_t index) {
+    while (index != NULL_NODE) {
+        index = balance(index);
+
+        Node& node = mNodes[index];
+        node.box = combine(mNodes[node.child1].box, mNodes[node.child2].box);
+        node.height = 1 + std::max(mNodes[node.child1].height, mNodes[node.child2].height);
+
+        index = node.parent;
+    }
+}
+
+int32_t AabbTree::balance(int32_t iA) {
+    Node& A = mNodes[iA];
+    if (A.isLeaf() || A.height < 2) return iA;
+
+    const int32_t iB = A.child1;
+    const int32_t iC = A.child2;
+    const int32_t difference = mNodes[iC].height - mNodes[iB].height;
+
+    // Более высокий ребёнок поднимается на место A, A опускается на его место
+    auto rotate = [&](int32_t iUp, int32_t iOther) {
+        Node& up = mNodes[iUp];
+        const int32_t iF = up.child1;
+        const int32_t iG = up.child2;
+
+        up.child1 = iA;
+        up.parent = mNodes[iA].parent;
+        mNodes[iA].parent = iUp;
+
+        if (up.parent == NULL_NODE) {
+            mRoot = iUp;
+        }
+        else if (mNodes[up.parent].child1 == iA) {
+            mNodes[up.parent].child1 = iUp;
+        }
+        else {
+            mNodes[up.parent].child2 = iUp;
+        }
+
+        // Более высокий внук остаётся у поднятого узла, другой переходит к A
+        const bool keepF = mNodes[iF].height > mNodes[iG].height;
+        const int32_t iKeep = keepF ? iF : iG;
+        const int32_t iMove = keepF ? iG : iF;
+
+        up.child2 = iKeep;
+        if (mNodes[iA].child1 == iUp) mNodes[iA].child1 = iMove;
+        else mNodes[iA].child2 = iMove;
+        mNodes[iMove].parent = iA;
+
+        Node& a = mNodes[iA];
+        a.box = combine(mNodes[iOther].box, mNodes[iMove].box);
+        a.height = 1 + std::max(mNodes[iOther].height, mNodes[iMove].height);
+        up.box = combine(a.box, mNodes[iKeep].box);
+        up.height = 1 + std::max(a.height, mNodes[iKeep].height);
+        return iUp;
+    };
+
+    if (difference > 1) return rotate(iC, iB);
+    if (difference < -1) return rotate(iB, iC);
+    return iA;
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+
+// Динамическое дерево AABB (по мотивам b2DynamicTree из Box2D). Листья хранят
+// "толстые" AABB с запасом, поэтому объект, сдвинувшийся в пределах запаса,
+// не трогает дерево. Вставка выбирает соседа по площади поверхности, после
+// изменений дерево балансируется поворотами, так что высота остаётся O(log n).
+// Запросы обходят только пересекающиеся узлы: O(log n + k).
+class AabbTree {
+public:
+    static constexpr int32_t NULL_NODE = -1;
+
+    // Запас толстого AABB с каждой стороны
+    static constexpr float MARGIN = 0.5f;
+
+    // Во сколько раз смещение за кадр растягивает толстый AABB вперёд
+    static constexpr float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+    // Возвращает номер листа (прокси), стабильный до destroyProxy
+    int32_t createProxy(const Aabb& box, void* userData);
+
+    void destroyProxy(int32_t proxy);
+
+    // true, если лист пришлось переставить (box вышел за толстый AABB)
+    bool moveProxy(int32_t proxy, const Aabb& box, const glm::vec3& displacement);
+
+    void* userData(int32_t proxy) const;
+
+    const Aabb& fatAabb(int32_t proxy) const;
+
+    // Обратный вызов получает прокси и возвращает false, чтобы прервать обход.
+    // Запросы делят стек обхода, поэтому из обратного вызова дерево не опрашивается
+    template<class Callback>
+    void query(const Frustum& frustum, Callback&& callback) const;
+
+    template<class Callback>
+    void query(const Aabb& box, Callback&& callback) const;
+
+    template<class Callback>
+    void query(const BoundingSphere& sphere, Callback&& callback) const;
+
+    // Обратный вызов получает прокси и точку входа в его толстый AABB и
+    // возвращает новую границу луча: 0 - остановить, maxT - не менять,
+    // меньшее значение - отсечь всё дальше найденного пересечения
+    template<class Callback>
+    void raycast(const Ray& ray, float maxT, Callback&& callback) const;
+
+    int32_t height() const;
+
+    size_t size() const;
+
+    void clear();
+
+private:
+    struct Node {
+        Aabb box;
+        void* userData = nullptr;
+        // Для свободного узла - следующий свободный
+        int32_t parent = NULL_NODE;
+        int32_t child1 = NULL_NODE;
+        int32_t child2 = NULL_NODE;
+        // Лист - 0, свободный узел - -1
+        int32_t height = -1;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    int32_t allocateNode();
+
+    void freeNode(int32_t node);
+
+    void insertLeaf(int32_t leaf);
+
+    void removeLeaf(int32_t leaf);
+
+    // Поворот вокруг узла с разбалансированными детьми, возвращает новый корень поддерева
+    int32_t balance(int32_t node);
+
+    // Пересчитывает границы и высоты от node до корня
+    void refit(int32_t node);
+
+    int32_t mRoot = NULL_NODE;
+    std::vector<Node> mNodes;
+    int32_t mFreeList = NULL_NODE;
+    size_t mProxyCount = 0;
+    // Стек обхода, переиспользуется между запросами
+    mutable std::vector<int32_t> mStack;
+};
+
+template<class Callback>
+void AabbTree::query(const Frustum& frustum, Callback&& callback) const {
+    if (mRoot == NULL_NODE) return;
+
+    // Поддерево, целиком попавшее в пирамиду, выдаётся без проверок
+    mStack.clear();
+    mStack.push_back(mRoot);
+    while (!mStack.empty()) {
+        const int32_t nodeId = mStack.back();
+        mStack.pop_back();
+        const Node& node = mNodes[nodeId];
+
+        const Frustum::Containment containment = frustum.classify(node.box);
+        if (containment == Frustum::Containment::Outside) continue;
+
+        if (containment == Frustum::Containment::Inside) {
+            const size_t base = mStack.size();
+            mStack.push_back(nodeId);
+            while (mStack.size() > base) {
+                const Node& inner = mNodes[mStack.back()];
+                const int32_t innerId = mStack.back();
+                mStack.pop_back();
+                if (inner.isLeaf()) {
+                    if (!callback(innerId)) return;
+                }
+                else {
+                    mStack.push_back(inner.child1);
+                    mStack.push_back(inner.child2);
+                }
+            }
+            continue;
+        }
+
+        if (node.isLeaf()) {
+            if (!callback(nodeId)) return;
+        }
+        else {
+            mStack.push_back(node.child1);
+            mStack.push_back(node.child2);
+        }
+    }
+}
+
+template<class Callback>
+void AabbTree::query(const Aabb& box, Callback&& callback) const {
+    if (mRoot == NULL_NODE) return;
+
+    mStack.clear();
+    mStack.push_back(mRoot);
+    while (!mStack.empty()) {
+        const int32_t nodeId = mStack.back();
+        mStack.pop_back();
+        const Node& node = mNodes[nodeId];
+        if (!node.box.overlaps(box)) continue;
+
+        if (node.isLeaf()) {
+            if (!callback(nodeId)) return;
+        }
+        else {
+            mStack.push_back(node.child1);
+            mStack.push_back(node.child2);
+        }
+    }
+}
+
+template<class Callback>
+void AabbTree::query(const BoundingSphere& sphere, Callback&& callback) const {
+    if (mRoot == NULL_NODE) return;
+
+    mStack.clear();
+    mStack.push_back(mRoot);
+    while (!mStack.empty()) {
+        const int32_t nodeId = mStack.back();
+        mStack.pop_back();
+        const Node& node = mNodes[nodeId];
+        if (!sphere.overlaps(node.box)) continue;
+
+        if (node.isLeaf()) {
+            if (!callback(nodeId)) return;
+        }
+        else {
+            mStack.push_back(node.child1);
+            mStack.push_back(node.child2);
+        }
+    }
+}
+
+template<class Callback>
+void AabbTree::raycast(const Ray& ray, float maxT, Callback&& callback) const {
+    if (mRoot == NULL_NODE) return;
+
+    mStack.clear();
+    mStack.push_back(mRoot);
+    while (!mStack.empty()) {
+        const int32_t nodeId = mStack.back();
+        mStack.pop_back();
+        const Node& node = mNodes[nodeId];
+
+        float tEnter;
+        if (!ray.intersects(node.box, maxT, tEnter)) continue;
+
+        if (node.isLeaf()) {
+            const float newMaxT = callback(nodeId, tEnter);
+            if (newMaxT <= 0.0f) return;
+            maxT = newMaxT;
+        }
+        else {
+            mStack.push_back(node.child1);
+            mStack.push_back(node.child2);
+        }
+    }
+}
@@ -3,14 +3,24 @@
 #include "callback_manager.h"
 #include "renderer.h"
 #include "game_object.h"
+#include "load_profiler.h"
+#include "gl_state_cache.h"
+#include "frame_data.h"
+#include "light_buffer.h"
+#include "material_registry.h"
+#include "scene_renderer.h"
+#include "scene_index.h"
+#include "occlusion_culler.h"
+#include "light_clusters.h"
+#include "dynamic_ring_buffer.h"
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/euler_angles.hpp>
 #include <chrono>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <memory>
 #include <random>
 #include <cmath>
-#define MAX_LIGHTS 10
 
 Application& Application::get_instance()
 {
@@ -67,24 +77,6 @@ void Application::init()
 
 }
 
-struct Light {
-	enum class Type {
-		Point = 0,
-		Directional = 1,
-		Spot = 2
-	};
-
-	int type;
-	glm::vec3 position;
-	glm::vec3 direction;
-	glm::vec3 color;
-	float intensity;
-	float constant;
-	float linear;
-	float quadratic;
-	float cutOff;
-};
-
 class PlayerControl
 {
 public:
@@ -133,6 +125,10 @@ public:
 
 		return result;
 	}
+	const std::vector<GameObject*>& GetClouds() const
+	{
+		return clouds;
+	}
 	void AddCloud(GameObject* cloud)
 	{
 		clouds.push_back(cloud);
@@ -164,16 +160,7 @@ public:
 CloudManager cloudManager = CloudManager();
 PlayerControl playerControl = PlayerControl();
 
-void RenderObject(GameObject* gameObject, ShaderProgram* program);
-glm::mat4 RotationMatrix(const glm::vec3& rotationAngles);
-void AddLight(Light* source);
-void RemoveLight(Light* source);
-void RemoveLastLight();
-void ApplyLight(ShaderProgram* program, Light* lightSource, int i);
-
 std::unordered_map<std::string, GameObject*> gameObjects;
-Light* lightSources[MAX_LIGHTS];
-int numLights = 0;
 auto lastTime = std::chrono::high_resolution_clock::now();
 void Application::start()
 {
@@ -188,61 +175,64 @@ void Application::start()
 	Renderer::setClearColor(65.0f / 255.0f, 74.0f / 255.0f, 76.0f / 255.0f, 1.0f);
 
 	ResourceManager* resources = &ResourceManager::getInstance();
-	//Texture2D* texture_skull = &resources->getTexture("skull");
-	//Texture2D* texture_barrel = &resources->getTexture("barrel");
-	//Mesh* skull_obj = &resources->getMesh("skull");
-	//Mesh* barrel_obj = &resources->getMesh("barrel");
+	//TextureHandle texture_skull = resources->findTexture("skull");
+	//TextureHandle texture_barrel = resources->findTexture("barrel");
+	//MeshHandle skull_obj = resources->findMesh("skull");
+	//MeshHandle barrel_obj = resources->findMesh("barrel");
+
+	// Все материалы - в одном SSBO, объект хранит только индекс
+	MaterialRegistry materialRegistry;
 
 #pragma region Materials
-	Material defaultMaterial = { glm::vec3(1.0f, 1.0f, 1.0f), // diffuseColor
+	MaterialId defaultMaterial = materialRegistry.add({ glm::vec3(1.0f, 1.0f, 1.0f), // diffuseColor
 				 glm::vec3(1.0f, 1.0f, 1.0f),  // specularColor
 				 glm::vec3(0.0f, 0.0f, 0.0f),  // emissionColor
 				 glm::vec3(0.01f, 0.01f, 0.01f),  // ambientColor
-				 32.0f };                      // shininess
-	Material planeMaterial = { glm::vec3(1.0f, 1.0f, 1.0f), // diffuseColor
+				 32.0f });                      // shininess
+	MaterialId planeMaterial = materialRegistry.add({ glm::vec3(1.0f, 1.0f, 1.0f), // diffuseColor
 					 glm::vec3(1.0f, 1.0f, 1.0f),  // specularColor
 					 glm::vec3(0.0f, 0.0f, 0.0f),  // emissionColor
 					 glm::vec3(0.05f, 0.05f, 0.05f),  // ambientColor
-					 8.0f };                      // shininess
-	Material lampMaterial = { glm::vec3(0.6f, 0.7f, 0.3f), // diffuseColor
+					 8.0f });                      // shininess
+	MaterialId lampMaterial = materialRegistry.add({ glm::vec3(0.6f, 0.7f, 0.3f), // diffuseColor
 					 glm::vec3(1.0f, 1.0f, 1.0f),  // specularColor
 					 glm::vec3(0.7f, 0.7f, 0.7f),  // emissionColor
 					 glm::vec3(0.01f, 0.01f, 0.01f),  // ambientColor
-					 32.0f };                      // shininess
-	Material cloudMaterial = { glm::vec3(0.5f, 0.5f, 0.5f), // diffuseColor
+					 32.0f });                      // shininess
+	MaterialId cloudMaterial = materialRegistry.add({ glm::vec3(0.5f, 0.5f, 0.5f), // diffuseColor
 					 glm::vec3(0.8f, 0.8f, 1.0f),  // specularColor
 					 glm::vec3(0.1f, 0.1f, 0.1f),  // emissionColor
 					 glm::vec3(0.2f, 0.2f, 0.2f),  // ambientColor
-					 64.0f };
+					 64.0f });
 #pragma endregion
 
 #pragma region Meshes and textures
-	Texture2D* terrainTex = &resources->getTexture("terrain");
-	Texture2D* planeTex = &resources->getTexture("plane");
-	Texture2D* treeTex = &resources->getTexture("tree");
-	Texture2D* boxTex = &resources->getTexture("box");
-	Texture2D* cloudTex = &resources->getTexture("cloud");
-	Texture2D* defaultTex = &resources->getTexture("default");
-	Mesh* terrainObj = &resources->getMesh("terrain");
-	Mesh* planeObj = &resources->getMesh("plane");
-	Mesh* treeObj = &resources->getMesh("tree");
-	Mesh* boxObj = &resources->getMesh("box");
-	Mesh* lampObj = &resources->getMesh("lamp");
-	Mesh* cloudObj = &resources->getMesh("cloud");
+	TextureHandle terrainTex = resources->findTexture("terrain");
+	TextureHandle planeTex = resources->findTexture("plane");
+	TextureHandle treeTex = resources->findTexture("tree");
+	TextureHandle boxTex = resources->findTexture("box");
+	TextureHandle cloudTex = resources->findTexture("cloud");
+	TextureHandle defaultTex = resources->findTexture("default");
+	MeshHandle terrainObj = resources->findMesh("terrain");
+	MeshHandle planeObj = resources->findMesh("plane");
+	MeshHandle treeObj = resources->findMesh("tree");
+	MeshHandle boxObj = resources->findMesh("box");
+	MeshHandle lampObj = resources->findMesh("lamp");
+	MeshHandle cloudObj = resources->findMesh("cloud");
 #pragma endregion
 
 	//GAME OBJECTS
-	gameObjects["terrain"] = new GameObject(terrainObj, terrainTex, &defaultMaterial, 4);
-	gameObjects["tree"] = new GameObject(treeObj, treeTex, &defaultMaterial, 0.1, glm::vec3(-26.2752, 16.8992, -10.8146), glm::vec3(-90,0,0));
-	gameObjects["player"] = new GameObject(planeObj, planeTex, &planeMaterial, 0.01, glm::vec3(-10, 28, -10), glm::vec3(-90, 0, 0));
-	gameObjects["lamp0"] = new GameObject(lampObj, defaultTex, &lampMaterial, 0.05, glm::vec3(-20.0657, 17.7, -14.6416));
-	gameObjects["lamp1"] = new GameObject(lampObj, defaultTex, &lampMaterial, 0.05, glm::vec3(-49.2922, 14.1686, -42.9111));
-	gameObjects["lamp2"] = new GameObject(lampObj, defaultTex, &lampMaterial, 0.05, glm::vec3(14.2697, 16.6533, -8.7417));
-	gameObjects["lamp3"] = new GameObject(lampObj, defaultTex, &lampMaterial, 0.05, glm::vec3(-22.5987, 13.2782, 29.4179));
+	gameObjects["terrain"] = new GameObject(terrainObj, terrainTex, defaultMaterial, 4);
+	gameObjects["tree"] = new GameObject(treeObj, treeTex, defaultMaterial, 0.1, glm::vec3(-26.2752, 16.8992, -10.8146), glm::vec3(-90,0,0));
+	gameObjects["player"] = new GameObject(planeObj, planeTex, planeMaterial, 0.01, glm::vec3(-10, 28, -10), glm::vec3(-90, 0, 0));
+	gameObjects["lamp0"] = new GameObject(lampObj, defaultTex, lampMaterial, 0.05, glm::vec3(-20.0657, 17.7, -14.6416));
+	gameObjects["lamp1"] = new GameObject(lampObj, defaultTex, lampMaterial, 0.05, glm::vec3(-49.2922, 14.1686, -42.9111));
+	gameObjects["lamp2"] = new GameObject(lampObj, defaultTex, lampMaterial, 0.05, glm::vec3(14.2697, 16.6533, -8.7417));
+	gameObjects["lamp3"] = new GameObject(lampObj, defaultTex, lampMaterial, 0.05, glm::vec3(-22.5987, 13.2782, 29.4179));
 
 	playerControl.player = gameObjects["player"];
 
-	//gameObjects["cloud0"] = new GameObject(cloudObj, cloudTex, &cloudMaterial, 0.75, glm::vec3(-22.5987, 30.2782, -10.8146), glm::vec3(-90, 0, 0));
+	//gameObjects["cloud0"] = new GameObject(cloudObj, cloudTex, cloudMaterial, 0.75, glm::vec3(-22.5987, 30.2782, -10.8146), glm::vec3(-90, 0, 0));
 
 	for (int i = 0; i < 6; ++i) {
 		// Генерация случайных координат и угла поворота
@@ -253,45 +243,58 @@ void Application::start()
 
 		// Создание объекта и добавление его в map
 		std::string objName = "cloud" + std::to_string(i);
-		gameObjects[objName] = new GameObject(cloudObj, cloudTex, &cloudMaterial, 0.75, glm::vec3(x, y, z), glm::vec3(-90, 0, rot));
+		gameObjects[objName] = new GameObject(cloudObj, cloudTex, cloudMaterial, 0.75, glm::vec3(x, y, z), glm::vec3(-90, 0, rot));
 		cloudManager.AddCloud(gameObjects[objName]);
 	}
 
-	//Матрица проекции - не меняется между кадрами, поэтому устанавливается вне цикла
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 200.0f);
-
-	ShaderProgram* directionalLight = &resources->getProgram("directionalLight");
-	directionalLight->use();
-	directionalLight->setUniform("projection", projection);
+	//Матрица проекции - не меняется между кадрами, но лежит в общем буфере кадра вместе с видом
+	const float fovY = glm::radians(45.0f);
+	const float aspect = 800.0f / 600.0f;
+	const float nearPlane = 0.1f;
+	const float farPlane = 200.0f;
+	glm::mat4 projection = glm::perspective(fovY, aspect, nearPlane, farPlane);
+
+	// Данные кадра пишутся memcpy в свою область кольцевого буфера
+	DynamicRingBuffer frameDataBuffer;
+	GLint uniformAlignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+
+	// Источники света - один SSBO без ограничения на количество
+	LightBuffer lightBuffer;
+
+	ProgramHandle lightingProgram = resources->findProgram("directionalLight");
+	ProgramHandle gbufferProgram = resources->findProgram("gbuffer");
+	ProgramHandle deferredLightingProgram = resources->findProgram("deferredLighting");
+	ProgramHandle depthProgram = resources->findProgram("depthOnly");
 	
 	//LIGHTS
-	AddLight(new Light{ (int)Light::Type::Directional, 
+	lightBuffer.add(Light{ (int)Light::Type::Directional, 
 			glm::vec3(), // pos
 			glm::vec3(-0.1, -0.8, -0.3), //dir
 			glm::vec3(1), //col
 			0.5}); //int
-	AddLight(new Light{ (int)Light::Type::Point, 
+	lightBuffer.add(Light{ (int)Light::Type::Point, 
 			glm::vec3(gameObjects["lamp0"]->position),
 			glm::vec3(), 
 			glm::vec3(1),
 			8,
 			0.5,
 			10});
-	AddLight(new Light{ (int)Light::Type::Point,
+	lightBuffer.add(Light{ (int)Light::Type::Point,
 			glm::vec3(gameObjects["lamp1"]->position),
 			glm::vec3(),
 			glm::vec3(1),
 			8,
 			0.5,
 			10 });
-	AddLight(new Light{ (int)Light::Type::Point,
+	lightBuffer.add(Light{ (int)Light::Type::Point,
 			glm::vec3(gameObjects["lamp2"]->position),
 			glm::vec3(),
 			glm::vec3(1),
 			8,
 			0.5,
 			10 });
-	AddLight(new Light{ (int)Light::Type::Point,
+	lightBuffer.add(Light{ (int)Light::Type::Point,
 			glm::vec3(gameObjects["lamp3"]->position),
 			glm::vec3(),
 			glm::vec3(1),
@@ -299,14 +302,36 @@ void Application::start()
 			0.5,
 			10 });
 
-	directionalLight->setUniform("numLights", numLights);
-	for (int i = 0; i < numLights; ++i) {
-		ApplyLight(directionalLight, lightSources[i], i);
+
+	// Точечные источники и прожекторы фрагмент берёт из списка своего кластера
+	LightClusters lightClusters;
+	lightClusters.setProjection(fovY, aspect, nearPlane, farPlane);
+
+	std::vector<GameObject*> sceneObjects;
+	for (const auto& x : gameObjects) sceneObjects.push_back(x.second);
+
+	// Видимость и прочие запросы к сцене идут через дерево, а не перебором всех объектов
+	SceneIndex sceneIndex;
+	for (GameObject* object : sceneObjects) sceneIndex.insert(object);
+	std::vector<GameObject*> visibleObjects;
+
+	// Рельеф закрывает большую часть сцены - он единственный окклюдер
+	OcclusionCuller occlusionCuller;
+	if (const Mesh* terrainMesh = resources->getMesh(gameObjects["terrain"]->mesh)) {
+		occlusionCuller.addOccluder(*terrainMesh, gameObjects["terrain"]->modelMatrix());
 	}
-	directionalLight->unbind();
+
+	auto sceneRenderer = std::make_unique<SceneRenderer>(lightingProgram, lightBuffer, materialRegistry);
+	// Отложенный путь включается клавишей F1, проход глубины - F2
+	sceneRenderer->setDeferredPrograms(gbufferProgram, deferredLightingProgram);
+	sceneRenderer->setDepthPrepassProgram(depthProgram);
+	// Все варианты шейдера, нужные сцене, отправляются драйверу сразу и собираются параллельно
+	sceneRenderer->prefetchPrograms(sceneObjects);
+	sceneRenderer->setOcclusionCuller(&occlusionCuller);
 
 	// Game loop
 	auto start = std::chrono::steady_clock::now();
+	uint64_t frameIndex = 0;
 	while (!glfwWindowShouldClose(window)) {
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
@@ -314,6 +339,9 @@ void Application::start()
 		float deltaTime = duration.count();
 		cloudManager.Update(deltaTime);
 		playerControl.Update(deltaTime);
+		// Двигаются только облака и игрок
+		for (GameObject* cloud : cloudManager.GetClouds()) sceneIndex.update(cloud);
+		sceneIndex.update(playerControl.player);
 		lastTime = currentTime;
 
 		glfwPollEvents();
@@ -322,18 +350,73 @@ void Application::start()
 		glm::mat4 view = camera.GetViewMatrix();
 		glm::vec3 viewPos = camera.GetPosition();
 
-		directionalLight->use();
-		directionalLight->setUniform("view", view);
-		directionalLight->setUniform("ViewPos", viewPos);
-		directionalLight->unbind();
-
-		for (const auto& x : gameObjects) {
-			RenderObject(x.second, directionalLight);
-		}
+		// Камера - одна запись в общий буфер, сколько бы программ её ни читало
+		const FrameData frameData{ view, projection, glm::vec4(viewPos, 1.0f) };
+		frameDataBuffer.beginFrame(sizeof(frameData) + uniformAlignment);
+		const unsigned int frameDataOffset = frameDataBuffer.write(&frameData, sizeof(frameData), uniformAlignment);
+		GLStateCache::bindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameDataBuffer.id(), frameDataOffset, sizeof(frameData));
+		lightBuffer.upload();
+		materialRegistry.upload();
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		lightClusters.update(lightBuffer, view, framebufferWidth, framebufferHeight);
+		sceneRenderer->setViewport(framebufferWidth, framebufferHeight);
+		sceneRenderer->setRenderPath(m_deferredShading ? SceneRenderer::RenderPath::Deferred : SceneRenderer::RenderPath::Forward);
+		sceneRenderer->setDepthPrepass(m_depthPrepass);
+
+		// Дерево отбрасывает целые поддеревья вне пирамиды, SceneRenderer уточняет по сферам и AABB.
+		// Порядок отрисовки задаёт очередь SceneRenderer, а не порядок хеш-таблицы
+		const glm::mat4 viewProjection = projection * view;
+		visibleObjects.clear();
+		sceneIndex.query(Frustum::fromMatrix(viewProjection), visibleObjects);
+		occlusionCuller.render(viewProjection);
+		sceneRenderer->render(visibleObjects, viewProjection, viewPos, farPlane);
+		// Всё, что читает данные кадра, уже отправлено
+		frameDataBuffer.endFrame();
+		lightClusters.endFrame();
 
 		// Swap the screen buffers
 		glfwSwapBuffers(window);
+		resourceManager->endFrame();
+
+		// Ресурсы догружаются при первом обращении, поэтому отчёт - после первого кадра
+		if (frameIndex == 0) {
+			LoadProfiler::getInstance().writeChromeTrace("load_trace.json");
+			LoadProfiler::getInstance().printSummary();
+		}
+		// Первый кадр нетипичен из-за загрузки, привязки считаем по второму
+		if (frameIndex == 1) {
+			const GLStateCache::Stats& glStats = GLStateCache::stats();
+			std::cout << "GL state changes per frame: issued " << glStats.issued << ", skipped " << glStats.skipped << std::endl;
+			const SceneRenderer::Stats& sceneStats = sceneRenderer->stats();
+			std::cout << "Scene: " << sceneStats.visible << "/" << sceneObjects.size() << " objects visible ("
+				<< sceneStats.objects << " from the tree), "
+				<< sceneStats.commands << " commands in " << sceneStats.drawCalls << " draw calls" << std::endl;
+			const OcclusionCuller::Stats& occlusionStats = occlusionCuller.stats();
+			std::cout << "Occlusion: " << occlusionStats.triangles << " occluder triangles, "
+				<< occlusionStats.occluded << "/" << occlusionStats.tested << " objects occluded" << std::endl;
+			const LightClusters::Stats& clusterStats = lightClusters.stats();
+			std::cout << "Light clusters: " << clusterStats.lights << " lights, " << clusterStats.references
+				<< " references, up to " << clusterStats.maxPerCluster << " per cluster" << std::endl;
+		}
+		// Время GPU раз в пару секунд - чтобы сравнить режимы, переключая их на лету
+		if (frameIndex % 120 == 0) {
+			const SceneRenderer::Stats& sceneStats = sceneRenderer->stats();
+			std::cout << "Frame " << frameIndex << ": " << (m_deferredShading ? "deferred" : "forward")
+				<< ", depth pre-pass " << (sceneStats.depthPrepass ? "on" : "off")
+				<< ", scene GPU time " << sceneStats.gpuMilliseconds << " ms, "
+				<< sceneStats.drawCalls << " draw calls" << std::endl;
+		}
+		GLStateCache::resetStats();
+		++frameIndex;
 	}
+	for (auto& x : gameObjects) delete x.second;
+	gameObjects.clear();
+	frameDataBuffer = DynamicRingBuffer(); // удаляем до уничтожения контекста
+	sceneRenderer.reset();
+	lightBuffer = LightBuffer();
+	lightClusters = LightClusters();
+	materialRegistry = MaterialRegistry();
 	resourceManager->destroy();
 	glfwTerminate();
 }
@@ -354,6 +437,18 @@ void Application::select_task(int value)
 	m_current_task = value;
 }
 
+void Application::ToggleDeferredShading()
+{
+	m_deferredShading = !m_deferredShading;
+	std::cout << "Render path: " << (m_deferredShading ? "deferred" : "forward") << std::endl;
+}
+
+void Application::ToggleDepthPrepass()
+{
+	m_depthPrepass = !m_depthPrepass;
+	std::cout << "Depth pre-pass: " << (m_depthPrepass ? "on" : "off") << std::endl;
+}
+
 void Application::PrintPosition()
 {
 	auto pos = camera.GetPosition();
@@ -387,81 +482,3 @@ void Application::ProcessKeyboard(PlayerMovement direction)
 }
 
 Application::Application(std::string name, int width, int height) : name(std::move(name)), width(width), height(height) {}
-
-glm::mat4 RotationMatrix(const glm::vec3& rotationAngles) {
-	glm::mat4 rotationMatrix = glm::eulerAngleXYZ(
-		glm::radians(rotationAngles.x), // pitch (тангаж)
-		glm::radians(rotationAngles.y), // yaw (рыскание)
-		glm::radians(rotationAngles.z)  // roll (крен)
-	);
-	return rotationMatrix;
-}
-void ApplyLight(ShaderProgram* program, Light* lightSource, int i)
-{
-	std::string prefix = "lights[" + std::to_string(i) + "].";
-	program->setUniform((prefix + "type").c_str(), lightSource->type);
-	program->setUniform((prefix + "position").c_str(), lightSource->position);
-	program->setUniform((prefix + "direction").c_str(), lightSource->direction);
-	program->setUniform((prefix + "color").c_str(), lightSource->color);
-	program->setUniform((prefix + "intensity").c_str(), lightSource->intensity);
-	program->setUniform((prefix + "constant").c_str(), lightSource->constant);
-	program->setUniform((prefix + "linear").c_str(), lightSource->linear);
-	program->setUniform((prefix + "quadratic").c_str(), lightSource->quadratic);
-	program->setUniform((prefix + "cutOff").c_str(), lightSource->cutOff);
-}
-
-void AddLight(Light* source) {
-	if (numLights < MAX_LIGHTS) {
-		lightSources[numLights] = source;
-		++numLights;
-	}
-}
-
-void RemoveLight(Light* source) {
-	if (numLights > 0) {
-		int indexToRemove = -1;
-		for (int i = 0; i < numLights; ++i) {
-			if (lightSources[i] == source) {
-				indexToRemove = i;
-				break;
-			}
-		}
-
-		if (indexToRemove != -1) {
-			lightSources[indexToRemove] = lightSources[numLights - 1];
-			--numLights;
-		}
-	}
-}
-void RemoveLastLight() {
-	if (numLights > 0) {
-		--numLights;
-	}
-}
-
-void RenderObject(GameObject* gameObject, ShaderProgram* program)
-{
-	//Матрица модели - меняется между кадрами, поэтому устанавливается в цикле
-	glm::mat4 model = glm::translate(glm::mat4(1.0f), gameObject->position);
-	model *= RotationMatrix(gameObject->rotation);
-	model = glm::scale(model, glm::vec3(gameObject->scale));
-
-	program->use();
-	program->setUniform("model", model);
-
-	program->setUniform("material.diffuseColor", gameObject->material->diffuseColor);
-	program->setUniform("material.specularColor", gameObject->material->specularColor);
-	program->setUniform("material.ambientColor", gameObject->material->ambientColor);
-	program->setUniform("material.emissionColor", gameObject->material->emissionColor);
-	program->setUniform("material.shininess", gameObject->material->shininess);
-
-	glActiveTexture(GL_TEXTURE0);
-	gameObject->texture->bind();
-
-	glBindVertexArray(gameObject->mesh->VAO);
-	glDrawArrays(GL_TRIANGLES, 0, gameObject->mesh->vertices.size());
-	glBindVertexArray(0);
-
-	gameObject->texture->unbind();
-	program->unbind();
-}
@@ -39,12 +39,18 @@ public:
 
 	void PrintPosition();
 	void ProcessKeyboard(PlayerMovement direction);
+	// Переключает прямое и отложенное освещение со следующего кадра
+	void ToggleDeferredShading();
+	// Включает и выключает предварительный проход глубины
+	void ToggleDepthPrepass();
 
 
 	Camera camera = Camera();
 private:
 	Application(std::string name, int width, int height);
 	int m_current_task = 1;
+	bool m_deferredShading = false;
+	bool m_depthPrepass = false;
 	std::string name;
 	int width;
 	int height;
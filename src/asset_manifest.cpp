@@ -0,0 +1,124 @@
+#include "asset_manifest.h"
+#include "mesh.h"
+#include "logger.hpp"
+
+#include <fstream>
+#include <sstream>
+
+static bool parseFlag(const std::string& value) {
+	return value == "1" || value == "true" || value == "yes";
+}
+
+static bool applyTextureOption(TextureParams& params, const std::string& key, const std::string& value) {
+	if (key == "wrap") {
+		if (value == "repeat") params.wrap = GL_REPEAT;
+		else if (value == "clamp") params.wrap = GL_CLAMP_TO_EDGE;
+		else return false;
+	}
+	else if (key == "filter") {
+		if (value == "nearest") {
+			params.minFilter = GL_NEAREST;
+			params.magFilter = GL_NEAREST;
+		}
+		else if (value == "linear") {
+			params.minFilter = GL_LINEAR;
+			params.magFilter = GL_LINEAR;
+		}
+		else if (value == "trilinear") {
+			params.minFilter = GL_LINEAR_MIPMAP_LINEAR;
+			params.magFilter = GL_LINEAR;
+			params.mipmaps = true;
+		}
+		else return false;
+	}
+	else if (key == "mipmaps") params.mipmaps = parseFlag(value);
+	else if (key == "flip") params.flipVertically = parseFlag(value);
+	else return false;
+	return true;
+}
+
+bool AssetManifest::load(const std::string& path) {
+	std::ifstream input(path);
+	if (!input.is_open()) {
+		Logger::error_log("Could not open manifest '" + path + "'");
+		return false;
+	}
+	std::stringstream buffer;
+	buffer << input.rdbuf();
+	return parse(buffer.str(), path);
+}
+
+bool AssetManifest::parse(const std::string& text, const std::string& sourceName) {
+	std::istringstream lines(text);
+	std::string line;
+	int lineNumber = 0;
+	bool ok = true;
+
+	while (std::getline(lines, line)) {
+		++lineNumber;
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		auto tokens = split(line, ' ');
+		// split() не режет по табуляции, поэтому разбираем её отдельно
+		std::vector<std::string> words;
+		for (const auto& token : tokens) {
+			for (auto& word : split(token, '\t')) words.push_back(std::move(word));
+		}
+		if (words.empty() || words[0][0] == '#') continue;
+
+		const std::string where = sourceName + ":" + std::to_string(lineNumber);
+		const std::string& type = words[0];
+		const size_t pathCount = (type == "program") ? 2 : 1;
+		if (words.size() < 2 + pathCount) {
+			Logger::error_log(where + ": expected name and path for '" + type + "'");
+			ok = false;
+			continue;
+		}
+
+		MeshDesc mesh;
+		TextureDesc texture;
+		ProgramDesc program;
+		bool preload = false;
+
+		for (size_t i = 2 + pathCount; i < words.size(); ++i) {
+			const size_t eq = words[i].find('=');
+			if (eq == std::string::npos) {
+				Logger::error_log(where + ": option '" + words[i] + "' must look like key=value");
+				ok = false;
+				continue;
+			}
+			const std::string key = words[i].substr(0, eq);
+			const std::string value = words[i].substr(eq + 1);
+			if (key == "preload") preload = parseFlag(value);
+			else if (type != "texture" || !applyTextureOption(texture.params, key, value)) {
+				Logger::error_log(where + ": unknown option '" + words[i] + "'");
+				ok = false;
+			}
+		}
+
+		if (type == "mesh") {
+			mesh.name = words[1];
+			mesh.path = words[2];
+			mesh.preload = preload;
+			meshes.push_back(std::move(mesh));
+		}
+		else if (type == "texture") {
+			texture.name = words[1];
+			texture.path = words[2];
+			texture.preload = preload;
+			textures.push_back(std::move(texture));
+		}
+		else if (type == "program") {
+			program.name = words[1];
+			program.vertexPath = words[2];
+			program.fragmentPath = words[3];
+			program.preload = preload;
+			programs.push_back(std::move(program));
+		}
+		else {
+			Logger::error_log(where + ": unknown asset type '" + type + "'");
+			ok = false;
+		}
+	}
+	return ok;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "texture.h"
+
+struct MeshDesc {
+    std::string name;
+    std::string path;
+    bool preload = false;
+};
+
+struct TextureDesc {
+    std::string name;
+    std::string path;
+    TextureParams params;
+    bool preload = false;
+};
+
+struct ProgramDesc {
+    std::string name;
+    std::string vertexPath;
+    std::string fragmentPath;
+    bool preload = false;
+};
+
+// Список ресурсов сцены. Формат - по одному ресурсу на строку:
+//   mesh    <name> <path>                       [option=value ...]
+//   texture <name> <path>                       [option=value ...]
+//   program <name> <vertexPath> <fragmentPath>  [option=value ...]
+// Опции: preload=1 (загрузить сразу), для текстур ещё
+// wrap=clamp|repeat, filter=linear|nearest|trilinear, mipmaps=0|1, flip=0|1.
+// Строки, начинающиеся с '#', игнорируются.
+class AssetManifest {
+public:
+    bool load(const std::string& path);
+
+    bool parse(const std::string& text, const std::string& sourceName = "manifest");
+
+    std::vector<MeshDesc> meshes;
+    std::vector<TextureDesc> textures;
+    std::vector<ProgramDesc> programs;
+};
@@ -0,0 +1,112 @@
+#include "bounds.h"
+#include <algorithm>
+#include <utility>
+
+void Aabb::expand(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void Aabb::expand(const Aabb& other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+bool Aabb::contains(const Aabb& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+        && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+}
+
+bool Aabb::overlaps(const Aabb& other) const {
+    return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y
+        && min.z <= other.max.z && other.min.z <= max.z;
+}
+
+float Aabb::surfaceArea() const {
+    const glm::vec3 size = max - min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+float Aabb::distanceSquared(const glm::vec3& point) const {
+    const glm::vec3 offset = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+    return glm::dot(offset, offset);
+}
+
+Aabb Aabb::transformed(const glm::mat4& matrix) const {
+    // Центр переносится матрицей, полуразмеры - модулем её линейной части
+    const glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center(), 1.0f));
+    const glm::vec3 e = extents();
+    const glm::vec3 newExtents =
+        glm::abs(glm::vec3(matrix[0])) * e.x + glm::abs(glm::vec3(matrix[1])) * e.y + glm::abs(glm::vec3(matrix[2])) * e.z;
+    return { newCenter - newExtents, newCenter + newExtents };
+}
+
+bool BoundingSphere::overlaps(const Aabb& box) const {
+    return box.distanceSquared(center) <= radius * radius;
+}
+
+bool Ray::intersects(const Aabb& box, float maxT, float& tEnter) const {
+    // Метод плит: пересечение интервалов t по трём осям
+    float tMin = 0.0f;
+    float tMax = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis]) return false;
+            continue;
+        }
+        const float inverse = 1.0f / direction[axis];
+        float t1 = (box.min[axis] - origin[axis]) * inverse;
+        float t2 = (box.max[axis] - origin[axis]) * inverse;
+        if (t1 > t2) std::swap(t1, t2);
+        tMin = std::max(tMin, t1);
+        tMax = std::min(tMax, t2);
+        if (tMin > tMax) return false;
+    }
+    tEnter = tMin;
+    return true;
+}
+
+Frustum Frustum::fromMatrix(const glm::mat4& viewProjection) {
+    // Плоскости - суммы и разности строк матрицы (Gribb, Hartmann)
+    const glm::mat4 m = glm::transpose(viewProjection);
+    Frustum frustum;
+    frustum.planes[Left] = m[3] + m[0];
+    frustum.planes[Right] = m[3] - m[0];
+    frustum.planes[Bottom] = m[3] + m[1];
+    frustum.planes[Top] = m[3] - m[1];
+    frustum.planes[Near] = m[3] + m[2];
+    frustum.planes[Far] = m[3] - m[2];
+    for (glm::vec4& plane : frustum.planes) plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+    for (const glm::vec4& plane : planes) {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const Aabb& box) const {
+    const glm::vec3 center = box.center();
+    const glm::vec3 extents = box.extents();
+    for (const glm::vec4& plane : planes) {
+        // Проекция полуразмеров на нормаль - "радиус" параллелепипеда относительно плоскости
+        const float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+    }
+    return true;
+}
+
+Frustum::Containment Frustum::classify(const Aabb& box) const {
+    const glm::vec3 center = box.center();
+    const glm::vec3 extents = box.extents();
+    Containment result = Containment::Inside;
+    for (const glm::vec4& plane : planes) {
+        const float radius = glm::dot(extents, glm::abs(glm::vec3(plane)));
+        const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        if (distance < -radius) return Containment::Outside;
+        if (distance < radius) result = Containment::Intersects;
+    }
+    return result;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cfloat>
+#include <glm/glm.hpp>
+
+// Ограничивающий параллелепипед, выровненный по осям
+struct Aabb {
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void expand(const glm::vec3& point);
+
+    void expand(const Aabb& other);
+
+    bool isValid() const { return min.x <= max.x; }
+
+    bool contains(const Aabb& other) const;
+
+    bool overlaps(const Aabb& other) const;
+
+    // Площадь поверхности - цена узла в эвристике AabbTree
+    float surfaceArea() const;
+
+    float distanceSquared(const glm::vec3& point) const;
+
+    glm::vec3 center() const { return (min + max) * 0.5f; }
+
+    glm::vec3 extents() const { return (max - min) * 0.5f; }
+
+    // AABB преобразованного параллелепипеда (не пересчитывая вершины меша)
+    Aabb transformed(const glm::mat4& matrix) const;
+};
+
+struct BoundingSphere {
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    bool overlaps(const Aabb& box) const;
+};
+
+// Луч origin + t * direction, direction не обязательно нормирован
+struct Ray {
+    glm::vec3 origin = glm::vec3(0.0f);
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+    // Пересечение с AABB при t из [0, maxT]; tEnter - точка входа
+    bool intersects(const Aabb& box, float maxT, float& tEnter) const;
+};
+
+// Пирамида видимости: шесть плоскостей (нормаль внутрь, w - смещение),
+// извлечённых из projection * view и нормированных
+struct Frustum {
+    enum Plane { Left, Right, Bottom, Top, Near, Far, PLANE_COUNT };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    bool intersects(const BoundingSphere& sphere) const;
+
+    bool intersects(const Aabb& box) const;
+
+    enum class Containment { Outside, Intersects, Inside };
+
+    // Inside - параллелепипед целиком внутри, потомков узла дерева можно не проверять
+    Containment classify(const Aabb& box) const;
+};
@@ -1,51 +1,74 @@
 #include "buffer_objects.h"
+#include "gl_state_cache.h"
 
-VBO::VBO() : mVBO(0) {}
+VBO::VBO() : mVBO(0), mCapacity(0) {}
 
 VBO::~VBO() {
+    GLStateCache::forgetBuffer(mVBO);
     glDeleteBuffers(1, &mVBO);
 }
 
 VBO::VBO(VBO&& vbo) noexcept {
     mVBO = vbo.mVBO;
+    mCapacity = vbo.mCapacity;
 
     vbo.mVBO = 0;
+    vbo.mCapacity = 0;
 }
 
 VBO& VBO::operator=(VBO&& vbo) noexcept {
     if (this != &vbo) {
+        GLStateCache::forgetBuffer(mVBO);
         glDeleteBuffers(1, &mVBO);
         mVBO = vbo.mVBO;
+        mCapacity = vbo.mCapacity;
 
         vbo.mVBO = 0;
-
+        vbo.mCapacity = 0;
     }
     return *this;
 }
 
 void VBO::init(const void* data, const unsigned int size) {
     glGenBuffers(1, &mVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVBO);
     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
 void VBO::update(const void* data, const unsigned int size) const {
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVBO);
     glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
 }
 
+void VBO::reserve(const unsigned int size) {
+    if (mVBO != 0 && size <= mCapacity) return;
+    if (mVBO == 0) glGenBuffers(1, &mVBO);
+
+    unsigned int capacity = mCapacity > 0 ? mCapacity : 256;
+    while (capacity < size) capacity *= 2;
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    mCapacity = capacity;
+}
+
 void VBO::bind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVBO);
 }
 
 void VBO::unbind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint VBO::id() const {
+    return mVBO;
 }
 
 
 EBO::EBO() : mEBO(0), mCount(0) {}
 
 EBO::~EBO() {
+    GLStateCache::forgetBuffer(mEBO);
     glDeleteBuffers(1, &mEBO);
 }
 
@@ -59,6 +82,7 @@ EBO::EBO(EBO&& ebo) noexcept {
 
 EBO& EBO::operator=(EBO&& ebo) noexcept {
     if (this != &ebo) {
+        GLStateCache::forgetBuffer(mEBO);
         glDeleteBuffers(1, &mEBO);
         mEBO = ebo.mEBO;
         mCount = ebo.mCount;
@@ -72,23 +96,117 @@ EBO& EBO::operator=(EBO&& ebo) noexcept {
 void EBO::init(const void* data, const unsigned int count) {
     mCount = count;
     glGenBuffers(1, &mEBO);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data, GL_STATIC_DRAW);
 }
 
 
 void EBO::bind() const {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
 }
 
 void EBO::unbind() const {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
 unsigned int EBO::count() const {
     return mCount;
 }
 
+UBO::UBO() : mUBO(0) {}
+
+UBO::~UBO() {
+    GLStateCache::forgetBuffer(mUBO);
+    glDeleteBuffers(1, &mUBO);
+}
+
+UBO::UBO(UBO&& ubo) noexcept {
+    mUBO = ubo.mUBO;
+
+    ubo.mUBO = 0;
+}
+
+UBO& UBO::operator=(UBO&& ubo) noexcept {
+    if (this != &ubo) {
+        GLStateCache::forgetBuffer(mUBO);
+        glDeleteBuffers(1, &mUBO);
+        mUBO = ubo.mUBO;
+
+        ubo.mUBO = 0;
+    }
+    return *this;
+}
+
+void UBO::init(const unsigned int size) {
+    glGenBuffers(1, &mUBO);
+    GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+void UBO::update(const void* data, const unsigned int size, const unsigned int offset) const {
+    GLStateCache::bindBuffer(GL_UNIFORM_BUFFER, mUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+void UBO::bindBase(GLuint binding) const {
+    GLStateCache::bindBufferBase(GL_UNIFORM_BUFFER, binding, mUBO);
+}
+
+SSBO::SSBO() : mSSBO(0), mCapacity(0) {}
+
+SSBO::~SSBO() {
+    GLStateCache::forgetBuffer(mSSBO);
+    glDeleteBuffers(1, &mSSBO);
+}
+
+SSBO::SSBO(SSBO&& ssbo) noexcept {
+    mSSBO = ssbo.mSSBO;
+    mCapacity = ssbo.mCapacity;
+
+    ssbo.mSSBO = 0;
+    ssbo.mCapacity = 0;
+}
+
+SSBO& SSBO::operator=(SSBO&& ssbo) noexcept {
+    if (this != &ssbo) {
+        GLStateCache::forgetBuffer(mSSBO);
+        glDeleteBuffers(1, &mSSBO);
+        mSSBO = ssbo.mSSBO;
+        mCapacity = ssbo.mCapacity;
+
+        ssbo.mSSBO = 0;
+        ssbo.mCapacity = 0;
+    }
+    return *this;
+}
+
+void SSBO::reserve(const unsigned int size) {
+    if (mSSBO != 0 && size <= mCapacity) return;
+    if (mSSBO == 0) glGenBuffers(1, &mSSBO);
+
+    // Запас вдвое, чтобы добавление по одному элементу не пересоздавало буфер каждый раз
+    unsigned int capacity = mCapacity > 0 ? mCapacity : 256;
+    while (capacity < size) capacity *= 2;
+
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+    mCapacity = capacity;
+}
+
+void SSBO::update(const void* data, const unsigned int size, const unsigned int offset) const {
+    GLStateCache::bindBuffer(GL_SHADER_STORAGE_BUFFER, mSSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
+
+void SSBO::bindBase(GLuint binding) const {
+    GLStateCache::bindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, mSSBO);
+}
+
+unsigned int SSBO::capacity() const {
+    return mCapacity;
+}
+
+
 VBOLayout::VBOLayout() : mStride(0) {}
 
 void VBOLayout::addLayoutElement(GLint count, GLenum type, GLboolean normalized) {
@@ -113,11 +231,11 @@ VAO::VAO() : mVAO(0) {
 }
 
 void VAO::bind() const {
-    glBindVertexArray(mVAO);
+    GLStateCache::bindVertexArray(mVAO);
 }
 
 void VAO::unbind() const {
-    glBindVertexArray(0);
+    GLStateCache::bindVertexArray(0);
 }
 
 void VAO::addBuffer(const VBO& buffer, const VBOLayout& layout, const unsigned int countVertex) {
@@ -142,6 +260,7 @@ unsigned int VAO::count() const {
 
 
 VAO::~VAO() {
+    GLStateCache::forgetVertexArray(mVAO);
     glDeleteVertexArrays(1, &mVAO);
 }
 
@@ -155,6 +274,7 @@ VAO::VAO(VAO&& vao) noexcept {
 
 VAO& VAO::operator=(VAO&& vao) noexcept {
     if (this != &vao) {
+        GLStateCache::forgetVertexArray(mVAO);
         glDeleteVertexArrays(1, &mVAO);
         mVAO = vao.mVAO;
         mVertexCount = vao.mVertexCount;
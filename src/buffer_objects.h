@@ -10,10 +10,15 @@ public:
 
     void update(const void* data, const unsigned int size) const;
 
+    // Гарантирует ёмкость не меньше size байт (GL_DYNAMIC_DRAW). При росте содержимое не сохраняется
+    void reserve(const unsigned int size);
+
     void bind() const;
 
     void unbind() const;
 
+    GLuint id() const;
+
     ~VBO();
 
     VBO(const VBO&) = delete;
@@ -26,6 +31,7 @@ public:
 
 private:
     GLuint mVBO;
+    unsigned int mCapacity;
 };
 
 
@@ -57,6 +63,60 @@ private:
     unsigned int mCount;
 };
 
+// Буфер uniform-блока, привязываемый к точке glBindBufferBase
+class UBO {
+public:
+    UBO();
+
+    void init(const unsigned int size);
+
+    void update(const void* data, const unsigned int size, const unsigned int offset = 0) const;
+
+    void bindBase(GLuint binding) const;
+
+    ~UBO();
+
+    UBO(const UBO&) = delete;
+
+    UBO& operator=(const UBO&) = delete;
+
+    UBO(UBO&& ubo) noexcept;
+
+    UBO& operator=(UBO&& ubo) noexcept;
+
+private:
+    GLuint mUBO;
+};
+
+// Буфер хранения (shader storage), растущий по мере надобности
+class SSBO {
+public:
+    SSBO();
+
+    // Гарантирует ёмкость не меньше size байт. При росте содержимое не сохраняется
+    void reserve(const unsigned int size);
+
+    void update(const void* data, const unsigned int size, const unsigned int offset = 0) const;
+
+    void bindBase(GLuint binding) const;
+
+    unsigned int capacity() const;
+
+    ~SSBO();
+
+    SSBO(const SSBO&) = delete;
+
+    SSBO& operator=(const SSBO&) = delete;
+
+    SSBO(SSBO&& ssbo) noexcept;
+
+    SSBO& operator=(SSBO&& ssbo) noexcept;
+
+private:
+    GLuint mSSBO;
+    unsigned int mCapacity;
+};
+
 struct VBOLayoutElements {
     GLint count;
     GLenum type;
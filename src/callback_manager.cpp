@@ -21,6 +21,12 @@ void CallbackManager::key_callback(GLFWwindow* window, int key, int scancode, in
 	if (key == GLFW_KEY_ENTER && action == GLFW_PRESS) {
 		Application::get_instance().PrintPosition();
 	}
+	if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+		Application::get_instance().ToggleDeferredShading();
+	}
+	if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+		Application::get_instance().ToggleDepthPrepass();
+	}
 	if (key == GLFW_KEY_W) {
 		Application::get_instance().camera.ProcessKeyboard(Camera_Movement::FORWARD, 0.2);
 	}
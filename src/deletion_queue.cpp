@@ -0,0 +1,20 @@
+#include "deletion_queue.h"
+
+void DeletionQueue::endFrame() {
+    ++mFrame;
+    while (!mQueue.empty() && mQueue.front().first + FRAMES_IN_FLIGHT <= mFrame) {
+        mQueue.pop_front();
+    }
+}
+
+void DeletionQueue::flush() {
+    mQueue.clear();
+}
+
+size_t DeletionQueue::size() const {
+    return mQueue.size();
+}
+
+uint64_t DeletionQueue::frame() const {
+    return mFrame;
+}
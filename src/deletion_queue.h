@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+// Очередь отложенного удаления GPU-ресурсов. Ресурс перемещается сюда целиком
+// и разрушается (вызывая glDelete* в своём деструкторе) только после того, как
+// кадры, которые могли его использовать, гарантированно завершились.
+class DeletionQueue {
+public:
+    // Сколько кадров драйвер может держать в очереди на исполнение
+    static constexpr uint64_t FRAMES_IN_FLIGHT = 2;
+
+    template<class T>
+    void push(T&& resource) {
+        mQueue.emplace_back(mFrame, std::make_unique<Retired<T>>(std::forward<T>(resource)));
+    }
+
+    // Вызывается в конце кадра, после SwapBuffers
+    void endFrame();
+
+    // Удаляет всё сразу (при завершении работы, когда GPU уже простаивает)
+    void flush();
+
+    size_t size() const;
+
+    uint64_t frame() const;
+
+private:
+    struct RetiredBase {
+        virtual ~RetiredBase() = default;
+    };
+
+    template<class T>
+    struct Retired : RetiredBase {
+        explicit Retired(T&& value) : resource(std::move(value)) {}
+        T resource;
+    };
+
+    uint64_t mFrame = 0;
+    std::deque<std::pair<uint64_t, std::unique_ptr<RetiredBase>>> mQueue;
+};
@@ -0,0 +1,120 @@
+#include "dynamic_ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+#include "gl_state_cache.h"
+
+// Области выровнены так, чтобы выравнивание смещения внутри области было и абсолютным
+static constexpr unsigned int REGION_ALIGNMENT = 256;
+
+void DynamicRingBuffer::beginFrame(unsigned int size) {
+    if (size > mRegionSize) {
+        // Запас вдвое, чтобы рост сцены не пересоздавал буфер каждый кадр
+        create(std::max({ size, mRegionSize * 2, 4096u }));
+    }
+    else {
+        mRegion = (mRegion + 1) % FRAME_COUNT;
+    }
+    mOffset = 0;
+
+    GLsync& fence = mFences[mRegion];
+    if (!fence) return;
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        ++mStalls;
+        GLenum result;
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+unsigned int DynamicRingBuffer::write(const void* data, unsigned int size, unsigned int alignment) {
+    alignment = std::max(alignment, 1u);
+    const unsigned int offset = (mOffset + alignment - 1) / alignment * alignment;
+    const unsigned int regionStart = mRegion * mRegionSize;
+    if (!mMapped || offset + size > mRegionSize) {
+        // Размер кадра в beginFrame занижен - лучше пропустить данные, чем затереть соседнюю область
+        std::cout << "ERROR::DYNAMIC_RING_BUFFER::FRAME_OVERFLOW" << std::endl;
+        return regionStart;
+    }
+    std::memcpy(mMapped + regionStart + offset, data, size);
+    mOffset = offset + size;
+    return regionStart + offset;
+}
+
+void DynamicRingBuffer::endFrame() {
+    if (mBuffer == 0) return;
+    if (mFences[mRegion]) glDeleteSync(mFences[mRegion]);
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint DynamicRingBuffer::id() const {
+    return mBuffer;
+}
+
+uint64_t DynamicRingBuffer::stalls() const {
+    return mStalls;
+}
+
+DynamicRingBuffer::~DynamicRingBuffer() {
+    release();
+}
+
+DynamicRingBuffer::DynamicRingBuffer(DynamicRingBuffer&& buffer) noexcept {
+    *this = std::move(buffer);
+}
+
+DynamicRingBuffer& DynamicRingBuffer::operator=(DynamicRingBuffer&& buffer) noexcept {
+    if (this != &buffer) {
+        release();
+        mBuffer = buffer.mBuffer;
+        mMapped = buffer.mMapped;
+        mRegionSize = buffer.mRegionSize;
+        mRegion = buffer.mRegion;
+        mOffset = buffer.mOffset;
+        mStalls = buffer.mStalls;
+        for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+            mFences[i] = buffer.mFences[i];
+            buffer.mFences[i] = nullptr;
+        }
+
+        buffer.mBuffer = 0;
+        buffer.mMapped = nullptr;
+        buffer.mRegionSize = 0;
+        buffer.mRegion = 0;
+        buffer.mOffset = 0;
+    }
+    return *this;
+}
+
+void DynamicRingBuffer::create(unsigned int regionSize) {
+    release();
+    mRegionSize = (regionSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT;
+    mRegion = 0;
+
+    // Создание через GL_COPY_WRITE_BUFFER не трогает привязки, которые помнит GLStateCache
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr size = static_cast<GLsizeiptr>(mRegionSize) * FRAME_COUNT;
+    glGenBuffers(1, &mBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mBuffer);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+    mMapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+    if (!mMapped) std::cout << "ERROR::DYNAMIC_RING_BUFFER::MAP_FAILED" << std::endl;
+}
+
+void DynamicRingBuffer::release() {
+    for (GLsync& fence : mFences) {
+        if (fence) glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (mBuffer == 0) return;
+    // Отображение снимается вместе с удалением буфера
+    GLStateCache::forgetBuffer(mBuffer);
+    glDeleteBuffers(1, &mBuffer);
+    mBuffer = 0;
+    mMapped = nullptr;
+    mRegionSize = 0;
+}
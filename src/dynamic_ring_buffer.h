@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <glad/gl.h>
+
+// Буфер для данных, которые пишутся заново каждый кадр (экземпляры, команды,
+// данные кадра). Хранилище glBufferStorage отображено в память один раз
+// (GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) и разделено на FRAME_COUNT
+// областей: кадр пишет в свою область обычным memcpy, пока GPU читает
+// предыдущие. Область снова занимается, только когда сработал её glFenceSync,
+// так что ни неявных копий драйвера, ни ожидания на glBufferSubData нет.
+class DynamicRingBuffer {
+public:
+    static constexpr uint32_t FRAME_COUNT = 3;
+
+    DynamicRingBuffer() = default;
+
+    // Переходит к следующей области, при необходимости дождавшись её fence.
+    // size - сколько байт кадр запишет, включая выравнивание; если область
+    // меньше, буфер пересоздаётся (старый драйвер удалит после GPU)
+    void beginFrame(unsigned int size);
+
+    // Копирует данные в область кадра и возвращает их смещение от начала буфера
+    unsigned int write(const void* data, unsigned int size, unsigned int alignment = 16);
+
+    // Ставит fence после всех команд, читающих область кадра
+    void endFrame();
+
+    GLuint id() const;
+
+    // Сколько раз beginFrame ждал GPU - если растёт, областей мало
+    uint64_t stalls() const;
+
+    ~DynamicRingBuffer();
+
+    DynamicRingBuffer(const DynamicRingBuffer&) = delete;
+
+    DynamicRingBuffer& operator=(const DynamicRingBuffer&) = delete;
+
+    DynamicRingBuffer(DynamicRingBuffer&& buffer) noexcept;
+
+    DynamicRingBuffer& operator=(DynamicRingBuffer&& buffer) noexcept;
+
+private:
+    void create(unsigned int regionSize);
+
+    void release();
+
+    GLuint mBuffer = 0;
+    unsigned char* mMapped = nullptr;
+    unsigned int mRegionSize = 0;
+    uint32_t mRegion = 0;
+    unsigned int mOffset = 0;
+    GLsync mFences[FRAME_COUNT] = {};
+    uint64_t mStalls = 0;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <glad/gl.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+// Точка привязки блока FrameData. ShaderProgram назначает её после линковки
+// каждой программе, в которой блок объявлен.
+constexpr GLuint FRAME_DATA_BINDING = 0;
+
+// Общие для всех программ данные кадра, раскладка std140 - как у блока FrameData в шейдерах
+struct FrameData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 viewPos; // vec3 в std140 всё равно занимает 16 байт, w не используется
+};
+
+static_assert(sizeof(FrameData) == 144, "FrameData must match the std140 layout of the shader block");
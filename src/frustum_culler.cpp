@@ -0,0 +1,75 @@
+#include "frustum_culler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+void FrustumCuller::clear() {
+    mCenterX.clear();
+    mCenterY.clear();
+    mCenterZ.clear();
+    mRadius.clear();
+    mCount = 0;
+}
+
+uint32_t FrustumCuller::add(const BoundingSphere& sphere) {
+    const uint32_t index = static_cast<uint32_t>(mCount++);
+    if (index == mRadius.size()) {
+        // Новая четвёрка: отрицательный радиус не даёт пройти ни одной плоскости
+        mCenterX.resize(index + 4, 0.0f);
+        mCenterY.resize(index + 4, 0.0f);
+        mCenterZ.resize(index + 4, 0.0f);
+        mRadius.resize(index + 4, -FLT_MAX);
+    }
+    mCenterX[index] = sphere.center.x;
+    mCenterY[index] = sphere.center.y;
+    mCenterZ[index] = sphere.center.z;
+    mRadius[index] = sphere.radius;
+    return index;
+}
+
+void FrustumCuller::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+    visible.clear();
+#ifdef FRUSTUM_CULLER_SSE
+    __m128 planeX[Frustum::PLANE_COUNT], planeY[Frustum::PLANE_COUNT];
+    __m128 planeZ[Frustum::PLANE_COUNT], planeW[Frustum::PLANE_COUNT];
+    for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+        planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+        planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+        planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+        planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+
+    for (size_t i = 0; i < mCount; i += 4) {
+        const __m128 x = _mm_loadu_ps(&mCenterX[i]);
+        const __m128 y = _mm_loadu_ps(&mCenterY[i]);
+        const __m128 z = _mm_loadu_ps(&mCenterZ[i]);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&mRadius[i]));
+
+        // Сфера видима, если для каждой плоскости расстояние до центра не меньше -r
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < Frustum::PLANE_COUNT; ++p) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), planeW[p]);
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], y));
+            distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], z));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        if (mask == 0) continue;
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1 << lane)) visible.push_back(static_cast<uint32_t>(i + lane));
+        }
+    }
+#else
+    for (size_t i = 0; i < mCount; ++i) {
+        const BoundingSphere sphere{ glm::vec3(mCenterX[i], mCenterY[i], mCenterZ[i]), mRadius[i] };
+        if (frustum.intersects(sphere)) visible.push_back(static_cast<uint32_t>(i));
+    }
+#endif
+}
+
+size_t FrustumCuller::size() const {
+    return mCount;
+}
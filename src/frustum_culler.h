@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+
+// Отсечение сфер по пирамиде видимости, по четыре сферы за итерацию (SSE).
+// Сферы хранятся покомпонентно (SoA), поэтому четыре центра и радиуса
+// загружаются в регистры без перестановок.
+class FrustumCuller {
+public:
+    void clear();
+
+    // Возвращает индекс сферы, который затем попадёт в список видимых
+    uint32_t add(const BoundingSphere& sphere);
+
+    // Индексы сфер, пересекающих пирамиду, по возрастанию
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+    size_t size() const;
+
+private:
+    // Длина массивов кратна 4, хвост заполнен сферами, которые всегда отсекаются
+    std::vector<float> mCenterX;
+    std::vector<float> mCenterY;
+    std::vector<float> mCenterZ;
+    std::vector<float> mRadius;
+    size_t mCount = 0;
+};
@@ -1,9 +1,10 @@
 #include "game_object.h"
+#include <glm/gtx/euler_angles.hpp>
 
-GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s, glm::vec3 p, glm::vec3 r)
+GameObject::GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s, glm::vec3 p, glm::vec3 r)
 {
-	mesh = _mesh;
-	texture = _texture;
+	mesh = MeshRef(_mesh);
+	texture = TextureRef(_texture);
 	material = _material;
 
 	position = p;
@@ -12,10 +13,10 @@ GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, fl
 	scale = s;
 }
 
-GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s, glm::vec3 p)
+GameObject::GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s, glm::vec3 p)
 {
-	mesh = _mesh;
-	texture = _texture;
+	mesh = MeshRef(_mesh);
+	texture = TextureRef(_texture);
 	material = _material;
 
 	position = p;
@@ -23,10 +24,10 @@ GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, fl
 	scale = s;
 }
 
-GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s)
+GameObject::GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s)
 {
-	mesh = _mesh;
-	texture = _texture;
+	mesh = MeshRef(_mesh);
+	texture = TextureRef(_texture);
 	material = _material;
 
 	position = glm::vec3();
@@ -34,13 +35,29 @@ GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, fl
 	scale = s;
 }
 
-GameObject::GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material)
+GameObject::GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material)
 {
-	mesh = _mesh;
-	texture = _texture;
+	mesh = MeshRef(_mesh);
+	texture = TextureRef(_texture);
 	material = _material;
 
 	position = glm::vec3();
 	rotation = glm::vec3(0);
 	scale = 1;
 }
+
+glm::mat4 GameObject::rotationMatrix() const
+{
+	return glm::eulerAngleXYZ(
+		glm::radians(rotation.x), // pitch (тангаж)
+		glm::radians(rotation.y), // yaw (рыскание)
+		glm::radians(rotation.z)  // roll (крен)
+	);
+}
+
+glm::mat4 GameObject::modelMatrix() const
+{
+	glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+	model *= rotationMatrix();
+	return glm::scale(model, glm::vec3(scale));
+}
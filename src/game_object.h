@@ -1,18 +1,24 @@
+#pragma once
 #include <glm/gtc/matrix_transform.hpp>
 #include "mesh.h"
 #include "texture.h"
 #include "material.h"
+#include "resource_ref.h"
 
 class GameObject {
 public:
-	Texture2D* texture;
-	Mesh* mesh;
-	Material* material;
+	TextureRef texture;
+	MeshRef mesh;
+	MaterialId material;
 	glm::vec3 position;
 	glm::vec3 rotation;
 	float scale;
-	GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s, glm::vec3 p, glm::vec3 r);
-	GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s, glm::vec3 p);
-	GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material, float s);
-	GameObject(Mesh* _mesh, Texture2D* _texture, Material* _material);
+	GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s, glm::vec3 p, glm::vec3 r);
+	GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s, glm::vec3 p);
+	GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material, float s);
+	GameObject(MeshHandle _mesh, TextureHandle _texture, MaterialId _material);
+
+	// Поворот по углам Эйлера в градусах (pitch, yaw, roll)
+	glm::mat4 rotationMatrix() const;
+	glm::mat4 modelMatrix() const;
 };
\ No newline at end of file
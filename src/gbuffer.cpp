@@ -0,0 +1,98 @@
+#include "gbuffer.h"
+#include <iostream>
+#include <utility>
+#include "gl_state_cache.h"
+
+void GBuffer::resize(int width, int height) {
+    if (mFramebuffer != 0 && width == mWidth && height == mHeight) return;
+    release();
+    mWidth = width;
+    mHeight = height;
+
+    struct Format {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        GLenum attachment;
+    };
+    const Format formats[ATTACHMENT_COUNT] = {
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_COLOR_ATTACHMENT0 },
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, GL_COLOR_ATTACHMENT1 },
+        { GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT, GL_COLOR_ATTACHMENT2 },
+        { GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, GL_DEPTH_ATTACHMENT },
+    };
+
+    glGenFramebuffers(1, &mFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    glGenTextures(ATTACHMENT_COUNT, mTextures);
+    for (GLuint i = 0; i < ATTACHMENT_COUNT; ++i) {
+        // Читаются texelFetch один к одному - фильтрация не нужна
+        GLStateCache::bindTexture(0, GL_TEXTURE_2D, mTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i].internalFormat, width, height, 0, formats[i].format, formats[i].type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, formats[i].attachment, GL_TEXTURE_2D, mTextures[i], 0);
+    }
+
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+    glDrawBuffers(3, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "ERROR::FRAMEBUFFER::GBUFFER_INCOMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::bindForWriting() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+    // Цвет не очищается: проход освещения пропускает пиксели с глубиной 1
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void GBuffer::bindTextures(GLuint firstUnit) const {
+    for (GLuint i = 0; i < ATTACHMENT_COUNT; ++i) {
+        GLStateCache::bindTexture(firstUnit + i, GL_TEXTURE_2D, mTextures[i]);
+    }
+}
+
+int GBuffer::width() const {
+    return mWidth;
+}
+
+int GBuffer::height() const {
+    return mHeight;
+}
+
+GBuffer::~GBuffer() {
+    release();
+}
+
+GBuffer::GBuffer(GBuffer&& gbuffer) noexcept {
+    *this = std::move(gbuffer);
+}
+
+GBuffer& GBuffer::operator=(GBuffer&& gbuffer) noexcept {
+    if (this != &gbuffer) {
+        release();
+        mFramebuffer = gbuffer.mFramebuffer;
+        mWidth = gbuffer.mWidth;
+        mHeight = gbuffer.mHeight;
+        for (GLuint i = 0; i < ATTACHMENT_COUNT; ++i) {
+            mTextures[i] = gbuffer.mTextures[i];
+            gbuffer.mTextures[i] = 0;
+        }
+
+        gbuffer.mFramebuffer = 0;
+        gbuffer.mWidth = 0;
+        gbuffer.mHeight = 0;
+    }
+    return *this;
+}
+
+void GBuffer::release() {
+    if (mFramebuffer == 0) return;
+    for (GLuint texture : mTextures) GLStateCache::forgetTexture(texture);
+    glDeleteTextures(ATTACHMENT_COUNT, mTextures);
+    glDeleteFramebuffers(1, &mFramebuffer);
+    for (GLuint& texture : mTextures) texture = 0;
+    mFramebuffer = 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <glad/gl.h>
+
+// Кадровый буфер отложенного освещения. Проход геометрии пишет в него
+// на каждый видимый пиксель:
+//   ALBEDO   - RGBA8, цвет текстуры (без текстуры - белый)
+//   NORMAL   - RGBA16F, нормаль в мировых координатах
+//   MATERIAL - R16UI, номер материала в MaterialBuffer: параметры материала
+//              проход освещения берёт оттуда же, что и прямой шейдер
+//   глубина  - DEPTH_COMPONENT32F, по ней восстанавливается позиция
+// Текстуры пересоздаются при смене размера окна.
+class GBuffer {
+public:
+    enum Attachment : GLuint {
+        ALBEDO = 0,
+        NORMAL = 1,
+        MATERIAL = 2,
+        DEPTH = 3,
+        ATTACHMENT_COUNT = 4
+    };
+
+    GBuffer() = default;
+
+    // Создаёт или пересоздаёт текстуры, если размер изменился
+    void resize(int width, int height);
+
+    // Привязывает буфер для прохода геометрии и очищает глубину
+    void bindForWriting() const;
+
+    // Текстуры на блоки firstUnit + Attachment, как layout(binding) в f_deferred.glsl
+    void bindTextures(GLuint firstUnit = 0) const;
+
+    int width() const;
+
+    int height() const;
+
+    ~GBuffer();
+
+    GBuffer(const GBuffer&) = delete;
+
+    GBuffer& operator=(const GBuffer&) = delete;
+
+    GBuffer(GBuffer&& gbuffer) noexcept;
+
+    GBuffer& operator=(GBuffer&& gbuffer) noexcept;
+
+private:
+    void release();
+
+    GLuint mFramebuffer = 0;
+    GLuint mTextures[ATTACHMENT_COUNT] = {};
+    int mWidth = 0;
+    int mHeight = 0;
+};
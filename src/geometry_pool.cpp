@@ -0,0 +1,211 @@
+#include "geometry_pool.h"
+#include <cstddef>
+#include <cstring>
+#include "gl_state_cache.h"
+#include "instance_data.h"
+
+// Точка привязки вершинного буфера пула в его VAO (в VAO глубины - буфера позиций)
+static constexpr GLuint VERTEX_BUFFER_BINDING = 0;
+
+static constexpr GLuint POSITION_SIZE = sizeof(MeshVertex::position);
+
+// Столбцы матрицы модели из буфера экземпляров, который SceneRenderer привязывает к INSTANCE_BUFFER_BINDING
+static void setupInstanceModel() {
+    for (GLuint column = 0; column < 4; ++column) {
+        const GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribFormat(location, 4, GL_FLOAT, GL_FALSE,
+            static_cast<GLuint>(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribBinding(location, INSTANCE_BUFFER_BINDING);
+    }
+    glVertexBindingDivisor(INSTANCE_BUFFER_BINDING, 1);
+}
+
+uint32_t GeometryPool::Allocator::allocate(uint32_t count) {
+    for (size_t i = 0; i < mFree.size(); ++i) {
+        Block& block = mFree[i];
+        if (block.count < count) continue;
+
+        const uint32_t offset = block.offset;
+        block.offset += count;
+        block.count -= count;
+        if (block.count == 0) mFree.erase(mFree.begin() + i);
+        return offset;
+    }
+    const uint32_t offset = mEnd;
+    mEnd += count;
+    return offset;
+}
+
+void GeometryPool::Allocator::free(uint32_t offset, uint32_t count) {
+    size_t i = 0;
+    while (i < mFree.size() && mFree[i].offset < offset) ++i;
+    mFree.insert(mFree.begin() + i, { offset, count });
+
+    // Слияние со следующим и с предыдущим блоком
+    if (i + 1 < mFree.size() && mFree[i].offset + mFree[i].count == mFree[i + 1].offset) {
+        mFree[i].count += mFree[i + 1].count;
+        mFree.erase(mFree.begin() + i + 1);
+    }
+    if (i > 0 && mFree[i - 1].offset + mFree[i - 1].count == mFree[i].offset) {
+        mFree[i - 1].count += mFree[i].count;
+        mFree.erase(mFree.begin() + i);
+        --i;
+    }
+
+    // Свободный хвост возвращается в конец
+    if (mFree[i].offset + mFree[i].count == mEnd) {
+        mEnd = mFree[i].offset;
+        mFree.erase(mFree.begin() + i);
+    }
+}
+
+void GeometryPool::Allocator::clear() {
+    mFree.clear();
+    mEnd = 0;
+}
+
+GeometryPool& GeometryPool::getInstance() {
+    static GeometryPool instance;
+
+    return instance;
+}
+
+GeometryPool::Range GeometryPool::allocate(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices) {
+    if (vertices.empty() || indices.empty()) return Range();
+    if (mVAO == 0) createVertexArrays();
+
+    Range range;
+    range.vertexCount = static_cast<uint32_t>(vertices.size());
+    range.indexCount = static_cast<uint32_t>(indices.size());
+    range.baseVertex = mVertices.allocate(range.vertexCount);
+    range.firstIndex = mIndices.allocate(range.indexCount);
+
+    if (mVertices.end() > mVertexCapacity) {
+        // Оба потока вершин растут вместе, ёмкость у них общая
+        uint32_t positionCapacity = mVertexCapacity;
+        grow(mVertexBuffer, mVertexCapacity, mVertices.end(), sizeof(MeshVertex));
+        grow(mPositionBuffer, positionCapacity, mVertices.end(), POSITION_SIZE);
+        GLStateCache::bindVertexArray(mVAO);
+        glBindVertexBuffer(VERTEX_BUFFER_BINDING, mVertexBuffer, 0, sizeof(MeshVertex));
+        GLStateCache::bindVertexArray(mDepthVAO);
+        glBindVertexBuffer(VERTEX_BUFFER_BINDING, mPositionBuffer, 0, POSITION_SIZE);
+    }
+    if (mIndices.end() > mIndexCapacity) {
+        grow(mIndexBuffer, mIndexCapacity, mIndices.end(), sizeof(uint32_t));
+        // Индексный буфер запоминается в VAO при привязке
+        GLStateCache::bindVertexArray(mVAO);
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+        GLStateCache::bindVertexArray(mDepthVAO);
+        GLStateCache::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer);
+    }
+
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mVertexBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.baseVertex) * sizeof(MeshVertex),
+        vertices.size() * sizeof(MeshVertex), vertices.data());
+
+    std::vector<GLfloat> positions(vertices.size() * 3);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        std::memcpy(&positions[i * 3], vertices[i].position, POSITION_SIZE);
+    }
+    GLStateCache::bindBuffer(GL_ARRAY_BUFFER, mPositionBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.baseVertex) * POSITION_SIZE,
+        positions.size() * sizeof(GLfloat), positions.data());
+
+    // GL_ELEMENT_ARRAY_BUFFER - состояние VAO, поэтому загрузка идёт через GL_COPY_WRITE_BUFFER
+    glBindBuffer(GL_COPY_WRITE_BUFFER, mIndexBuffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(range.firstIndex) * sizeof(uint32_t),
+        indices.size() * sizeof(uint32_t), indices.data());
+    return range;
+}
+
+void GeometryPool::release(const Range& range) {
+    if (!range.isValid() || mVAO == 0) return;
+    mVertices.free(range.baseVertex, range.vertexCount);
+    mIndices.free(range.firstIndex, range.indexCount);
+}
+
+GLuint GeometryPool::vao() const {
+    return mVAO;
+}
+
+GLuint GeometryPool::depthVao() const {
+    return mDepthVAO;
+}
+
+void GeometryPool::destroy() {
+    GLStateCache::forgetVertexArray(mVAO);
+    GLStateCache::forgetVertexArray(mDepthVAO);
+    GLStateCache::forgetBuffer(mVertexBuffer);
+    GLStateCache::forgetBuffer(mPositionBuffer);
+    GLStateCache::forgetBuffer(mIndexBuffer);
+    if (mVAO != 0) glDeleteVertexArrays(1, &mVAO);
+    if (mDepthVAO != 0) glDeleteVertexArrays(1, &mDepthVAO);
+    if (mVertexBuffer != 0) glDeleteBuffers(1, &mVertexBuffer);
+    if (mPositionBuffer != 0) glDeleteBuffers(1, &mPositionBuffer);
+    if (mIndexBuffer != 0) glDeleteBuffers(1, &mIndexBuffer);
+    mVAO = mDepthVAO = mVertexBuffer = mPositionBuffer = mIndexBuffer = 0;
+    mVertexCapacity = mIndexCapacity = 0;
+    mVertices.clear();
+    mIndices.clear();
+}
+
+void GeometryPool::createVertexArrays() {
+    glGenVertexArrays(1, &mVAO);
+    GLStateCache::bindVertexArray(mVAO);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(MeshVertex, position)));
+    glVertexAttribBinding(0, VERTEX_BUFFER_BINDING);
+
+    glEnableVertexAttribArray(1);
+    glVertexAttribFormat(1, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(MeshVertex, normal)));
+    glVertexAttribBinding(1, VERTEX_BUFFER_BINDING);
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(MeshVertex, texture)));
+    glVertexAttribBinding(2, VERTEX_BUFFER_BINDING);
+
+    // Атрибуты экземпляра читаются из буфера, который SceneRenderer привязывает к INSTANCE_BUFFER_BINDING
+    setupInstanceModel();
+    for (GLuint column = 0; column < 3; ++column) {
+        const GLuint location = INSTANCE_NORMAL_LOCATION + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribFormat(location, 3, GL_FLOAT, GL_FALSE,
+            static_cast<GLuint>(offsetof(InstanceData, normalMatrix) + column * sizeof(glm::vec3)));
+        glVertexAttribBinding(location, INSTANCE_BUFFER_BINDING);
+    }
+    glEnableVertexAttribArray(INSTANCE_MATERIAL_LOCATION);
+    glVertexAttribIFormat(INSTANCE_MATERIAL_LOCATION, 1, GL_INT, static_cast<GLuint>(offsetof(InstanceData, materialIndex)));
+    glVertexAttribBinding(INSTANCE_MATERIAL_LOCATION, INSTANCE_BUFFER_BINDING);
+
+    glGenVertexArrays(1, &mDepthVAO);
+    GLStateCache::bindVertexArray(mDepthVAO);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, VERTEX_BUFFER_BINDING);
+    setupInstanceModel();
+
+    GLStateCache::bindVertexArray(0);
+}
+
+void GeometryPool::grow(GLuint& buffer, uint32_t& capacity, uint32_t required, uint32_t elementSize) {
+    // Запас вдвое: меши подгружаются по одному, и каждый не должен пересоздавать буфер
+    uint32_t newCapacity = capacity > 0 ? capacity : 4096;
+    while (newCapacity < required) newCapacity *= 2;
+
+    GLuint newBuffer = 0;
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(newCapacity) * elementSize, nullptr, GL_STATIC_DRAW);
+
+    if (buffer != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(capacity) * elementSize);
+        GLStateCache::forgetBuffer(buffer);
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = newBuffer;
+    capacity = newCapacity;
+}
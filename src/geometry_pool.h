@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glad/gl.h>
+
+struct MeshVertex {
+    GLfloat position[3];
+    GLfloat normal[3];
+    GLfloat texture[2];
+};
+
+// Общее хранилище геометрии: вершины и индексы всех мешей лежат в двух
+// больших буферах под одним VAO. Меш - это диапазон в них, поэтому разные
+// меши рисуются без смены VAO, в том числе одним glMultiDrawElementsIndirect.
+// Позиции дополнительно лежат отдельным плотным потоком для прохода глубины:
+// у его VAO те же индексы и смещения, но вершина занимает 12 байт вместо 32.
+class GeometryPool {
+public:
+    // Индексы диапазона отсчитываются от baseVertex
+    struct Range {
+        uint32_t baseVertex = 0;
+        uint32_t vertexCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+
+        bool isValid() const { return indexCount != 0; }
+    };
+
+    static GeometryPool& getInstance();
+
+    Range allocate(const std::vector<MeshVertex>& vertices, const std::vector<uint32_t>& indices);
+
+    void release(const Range& range);
+
+    GLuint vao() const;
+
+    // Только позиции и матрица экземпляра (location 0 и INSTANCE_MODEL_LOCATION)
+    GLuint depthVao() const;
+
+    // Освобождает буферы (при завершении работы, после удаления мешей)
+    void destroy();
+
+private:
+    // Первый подходящий свободный блок, иначе место в конце
+    class Allocator {
+    public:
+        uint32_t allocate(uint32_t count);
+
+        void free(uint32_t offset, uint32_t count);
+
+        // Граница занятой части: всё, что дальше, свободно
+        uint32_t end() const { return mEnd; }
+
+        void clear();
+
+    private:
+        struct Block {
+            uint32_t offset;
+            uint32_t count;
+        };
+
+        // Отсортированы по смещению, соседние блоки слиты
+        std::vector<Block> mFree;
+        uint32_t mEnd = 0;
+    };
+
+    GeometryPool() = default;
+
+    void createVertexArrays();
+
+    // Пересоздаёт буфер большей ёмкости, перенося данные на стороне GPU
+    static void grow(GLuint& buffer, uint32_t& capacity, uint32_t required, uint32_t elementSize);
+
+    GLuint mVAO = 0;
+    GLuint mDepthVAO = 0;
+    GLuint mVertexBuffer = 0;
+    GLuint mPositionBuffer = 0;
+    GLuint mIndexBuffer = 0;
+    uint32_t mVertexCapacity = 0;
+    uint32_t mIndexCapacity = 0;
+    Allocator mVertices;
+    Allocator mIndices;
+};
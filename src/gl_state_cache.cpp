@@ -0,0 +1,195 @@
+#include "gl_state_cache.h"
+
+namespace {
+
+// Значение "неизвестно": следующий вызов будет выполнен в любом случае
+constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+
+enum BufferSlot {
+    ArrayBuffer,
+    ElementArrayBuffer,
+    UniformBuffer,
+    ShaderStorageBuffer,
+    DrawIndirectBuffer,
+    BufferSlotCount
+};
+
+int bufferSlot(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return ArrayBuffer;
+    case GL_ELEMENT_ARRAY_BUFFER: return ElementArrayBuffer;
+    case GL_UNIFORM_BUFFER: return UniformBuffer;
+    case GL_SHADER_STORAGE_BUFFER: return ShaderStorageBuffer;
+    case GL_DRAW_INDIRECT_BUFFER: return DrawIndirectBuffer;
+    default: return -1;
+    }
+}
+
+int indexedSlot(GLenum target) {
+    switch (target) {
+    case GL_UNIFORM_BUFFER: return 0;
+    case GL_SHADER_STORAGE_BUFFER: return 1;
+    default: return -1;
+    }
+}
+
+struct State {
+    GLuint program = UNKNOWN;
+    GLuint vao = UNKNOWN;
+    GLuint activeUnit = UNKNOWN;
+    GLuint textures[GLStateCache::MAX_TEXTURE_UNITS];
+    GLenum textureTargets[GLStateCache::MAX_TEXTURE_UNITS];
+    GLuint buffers[BufferSlotCount];
+    GLuint indexed[2][GLStateCache::MAX_INDEXED_BINDINGS];
+    GLStateCache::Stats stats;
+
+    State() { reset(); }
+
+    void reset() {
+        program = vao = activeUnit = UNKNOWN;
+        for (GLuint i = 0; i < GLStateCache::MAX_TEXTURE_UNITS; ++i) {
+            textures[i] = UNKNOWN;
+            textureTargets[i] = 0;
+        }
+        for (GLuint& buffer : buffers) buffer = UNKNOWN;
+        for (auto& bindings : indexed) {
+            for (GLuint& buffer : bindings) buffer = UNKNOWN;
+        }
+    }
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+// true - вызов нужен; кэш уже обновлён
+bool change(GLuint& cached, GLuint value) {
+    GLStateCache::Stats& stats = state().stats;
+    if (cached == value) {
+        ++stats.skipped;
+        return false;
+    }
+    cached = value;
+    ++stats.issued;
+    return true;
+}
+
+}
+
+void GLStateCache::useProgram(GLuint program) {
+    if (change(state().program, program)) glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+    State& s = state();
+    if (change(s.vao, vao)) {
+        glBindVertexArray(vao);
+        // Привязка индексного буфера хранится в VAO
+        s.buffers[ElementArrayBuffer] = UNKNOWN;
+    }
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    State& s = state();
+    if (unit >= MAX_TEXTURE_UNITS) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, texture);
+        s.activeUnit = unit;
+        s.stats.issued += 2;
+        return;
+    }
+    if (s.textureTargets[unit] != target) {
+        s.textureTargets[unit] = target;
+        s.textures[unit] = UNKNOWN;
+    }
+    if (s.textures[unit] == texture) {
+        ++s.stats.skipped;
+        return;
+    }
+    if (change(s.activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+    change(s.textures[unit], texture);
+    glBindTexture(target, texture);
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    const int slot = bufferSlot(target);
+    if (slot < 0) {
+        glBindBuffer(target, buffer);
+        ++state().stats.issued;
+        return;
+    }
+    if (change(state().buffers[slot], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    State& s = state();
+    const int slot = indexedSlot(target);
+    if (slot < 0 || index >= MAX_INDEXED_BINDINGS) {
+        glBindBufferBase(target, index, buffer);
+        ++s.stats.issued;
+    }
+    else if (change(s.indexed[slot][index], buffer)) {
+        glBindBufferBase(target, index, buffer);
+    }
+    else {
+        return;
+    }
+    // glBindBufferBase привязывает буфер и к общей точке target
+    const int generic = bufferSlot(target);
+    if (generic >= 0) s.buffers[generic] = buffer;
+}
+
+void GLStateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    State& s = state();
+    glBindBufferRange(target, index, buffer, offset, size);
+    ++s.stats.issued;
+    // Кэш помнит только буфер целиком - следующий bindBufferBase в эту точку нужен в любом случае
+    const int slot = indexedSlot(target);
+    if (slot >= 0 && index < MAX_INDEXED_BINDINGS) s.indexed[slot][index] = UNKNOWN;
+    const int generic = bufferSlot(target);
+    if (generic >= 0) s.buffers[generic] = buffer;
+}
+
+void GLStateCache::forgetProgram(GLuint program) {
+    State& s = state();
+    if (program != 0 && s.program == program) s.program = UNKNOWN;
+}
+
+void GLStateCache::forgetVertexArray(GLuint vao) {
+    State& s = state();
+    if (vao != 0 && s.vao == vao) s.vao = 0;
+}
+
+void GLStateCache::forgetTexture(GLuint texture) {
+    if (texture == 0) return;
+    State& s = state();
+    for (GLuint& bound : s.textures) {
+        if (bound == texture) bound = 0;
+    }
+}
+
+void GLStateCache::forgetBuffer(GLuint buffer) {
+    if (buffer == 0) return;
+    State& s = state();
+    for (GLuint& bound : s.buffers) {
+        if (bound == buffer) bound = 0;
+    }
+    for (auto& bindings : s.indexed) {
+        for (GLuint& bound : bindings) {
+            if (bound == buffer) bound = 0;
+        }
+    }
+}
+
+void GLStateCache::invalidate() {
+    state().reset();
+}
+
+const GLStateCache::Stats& GLStateCache::stats() {
+    return state().stats;
+}
+
+void GLStateCache::resetStats() {
+    state().stats = Stats();
+}
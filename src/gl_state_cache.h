@@ -0,0 +1,49 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstdint>
+
+// Кэш привязок GL текущего контекста: программа, VAO, текстурные блоки и буферы.
+// Вызов, который ничего не меняет, пропускается. Все обёртки (ShaderProgram,
+// Texture2D, VAO, буферы, Renderer) привязывают объекты только через него,
+// а при удалении объекта сообщают об этом - иначе имя, выданное драйвером
+// повторно, считалось бы уже привязанным.
+class GLStateCache {
+public:
+    static constexpr GLuint MAX_TEXTURE_UNITS = 32;
+
+    static constexpr GLuint MAX_INDEXED_BINDINGS = 16;
+
+    struct Stats {
+        uint64_t issued = 0;
+        uint64_t skipped = 0;
+    };
+
+    static void useProgram(GLuint program);
+
+    static void bindVertexArray(GLuint vao);
+
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // Диапазоны (области DynamicRingBuffer) меняются каждый кадр - вызов не пропускается
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    // Вызываются перед glDelete*: удалённый объект отвязывается драйвером
+    static void forgetProgram(GLuint program);
+
+    static void forgetVertexArray(GLuint vao);
+
+    static void forgetTexture(GLuint texture);
+
+    static void forgetBuffer(GLuint buffer);
+
+    // После кода, меняющего привязки в обход кэша, и при смене контекста
+    static void invalidate();
+
+    static const Stats& stats();
+
+    static void resetStats();
+};
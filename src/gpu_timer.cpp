@@ -0,0 +1,29 @@
+#include "gpu_timer.h"
+
+void GpuTimer::begin() {
+    if (mQueries[0] == 0) glGenQueries(LATENCY, mQueries);
+
+    // Запрос этого слота был отправлен LATENCY кадров назад
+    const uint32_t slot = mFrame % LATENCY;
+    if (mPending[slot]) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(mQueries[slot], GL_QUERY_RESULT, &nanoseconds);
+        mMilliseconds = static_cast<float>(nanoseconds) * 1e-6f;
+        mPending[slot] = false;
+    }
+    glBeginQuery(GL_TIME_ELAPSED, mQueries[slot]);
+}
+
+void GpuTimer::end() {
+    glEndQuery(GL_TIME_ELAPSED);
+    mPending[mFrame % LATENCY] = true;
+    ++mFrame;
+}
+
+float GpuTimer::milliseconds() const {
+    return mMilliseconds;
+}
+
+GpuTimer::~GpuTimer() {
+    if (mQueries[0] != 0) glDeleteQueries(LATENCY, mQueries);
+}
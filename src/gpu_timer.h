@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <glad/gl.h>
+
+// Время GPU на участок кадра по запросам GL_TIME_ELAPSED. Результат читается
+// через LATENCY кадров, когда он уже готов, так что ожидания драйвера нет.
+// Одновременно может быть открыт только один такой участок на контекст.
+class GpuTimer {
+public:
+    static constexpr uint32_t LATENCY = 3;
+
+    GpuTimer() = default;
+
+    void begin();
+
+    void end();
+
+    // Последний прочитанный замер в миллисекундах, 0 - пока нет ни одного
+    float milliseconds() const;
+
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+private:
+    GLuint mQueries[LATENCY] = {};
+    bool mPending[LATENCY] = {};
+    uint32_t mFrame = 0;
+    float mMilliseconds = 0.0f;
+};
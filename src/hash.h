@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// FNV-1a, 64 бита. constexpr, поэтому годится и для ключей, вычисляемых при компиляции.
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+constexpr uint64_t fnv1a64(const char* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+constexpr uint64_t fnv1a64(std::string_view text, uint64_t hash = FNV_OFFSET_BASIS) {
+    return fnv1a64(text.data(), text.size(), hash);
+}
+
+// "model"_hash - хеш строки на этапе компиляции
+constexpr uint64_t operator""_hash(const char* text, size_t size) {
+    return fnv1a64(text, size);
+}
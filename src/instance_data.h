@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+#include <glad/gl.h>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+
+// Точка привязки буфера экземпляров в VAO меша (glBindVertexBuffer, делитель 1)
+constexpr GLuint INSTANCE_BUFFER_BINDING = 15;
+
+// Атрибуты экземпляра в v_lighting.glsl: mat4 занимает 4 слота, mat3 - 3
+constexpr GLuint INSTANCE_MODEL_LOCATION = 3;
+constexpr GLuint INSTANCE_NORMAL_LOCATION = 7;
+constexpr GLuint INSTANCE_MATERIAL_LOCATION = 10;
+
+// Данные одного экземпляра в буфере экземпляров
+struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    int32_t materialIndex;
+};
+
+static_assert(sizeof(InstanceData) == 104, "InstanceData must be tightly packed");
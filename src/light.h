@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+struct Light {
+    enum class Type {
+        Point = 0,
+        Directional = 1,
+        Spot = 2
+    };
+
+    int type;
+    glm::vec3 position;
+    glm::vec3 direction;
+    glm::vec3 color;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    float cutOff;
+};
+
+// Источник света в буфере LightBuffer, раскладка std430 - как у struct Light в f_lighting.glsl.
+// vec3 дополнен скаляром до 16 байт, чтобы структура была плотной.
+struct GpuLight {
+    glm::vec3 position;
+    int32_t type;
+    glm::vec3 direction;
+    float cutOff;
+    glm::vec3 color;
+    float intensity;
+    float constant;
+    float linear;
+    float quadratic;
+    float padding;
+};
+
+static_assert(sizeof(GpuLight) == 64, "GpuLight must match the std430 layout of the shader struct");
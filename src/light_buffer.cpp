@@ -0,0 +1,75 @@
+#include "light_buffer.h"
+#include <cstring>
+
+size_t LightBuffer::add(const Light& light) {
+    mLights.push_back(light);
+    mDirty = true;
+    return mLights.size() - 1;
+}
+
+Light& LightBuffer::get(size_t index) {
+    mDirty = true;
+    return mLights[index];
+}
+
+const Light& LightBuffer::get(size_t index) const {
+    return mLights[index];
+}
+
+void LightBuffer::remove(size_t index) {
+    if (index >= mLights.size()) return;
+    mLights[index] = mLights.back();
+    mLights.pop_back();
+    mDirty = true;
+}
+
+void LightBuffer::removeLast() {
+    if (mLights.empty()) return;
+    mLights.pop_back();
+    mDirty = true;
+}
+
+size_t LightBuffer::size() const {
+    return mLights.size();
+}
+
+int LightBuffer::count(Light::Type type) const {
+    int result = 0;
+    for (const Light& light : mLights) {
+        if (light.type == static_cast<int>(type)) ++result;
+    }
+    return result;
+}
+
+const std::vector<uint32_t>& LightBuffer::gpuOrder() const {
+    return mGpuOrder;
+}
+
+void LightBuffer::upload() {
+    if (mDirty) {
+        mStaging.resize(sizeof(Header) + mLights.size() * sizeof(GpuLight));
+
+        Header header = { count(Light::Type::Directional), count(Light::Type::Point), count(Light::Type::Spot), 0 };
+        std::memcpy(mStaging.data(), &header, sizeof(header));
+
+        // Направленные идут первыми - шейдер обходит их циклом по directionalCount
+        const Light::Type order[] = { Light::Type::Directional, Light::Type::Point, Light::Type::Spot };
+        GpuLight* gpuLights = reinterpret_cast<GpuLight*>(mStaging.data() + sizeof(Header));
+        mGpuOrder.clear();
+        size_t written = 0;
+        for (Light::Type type : order) {
+            for (uint32_t i = 0; i < mLights.size(); ++i) {
+                const Light& light = mLights[i];
+                if (light.type != static_cast<int>(type)) continue;
+                mGpuOrder.push_back(i);
+                gpuLights[written++] = { light.position, light.type, light.direction, light.cutOff,
+                    light.color, light.intensity, light.constant, light.linear, light.quadratic, 0.0f };
+            }
+        }
+
+        mBuffer.reserve(static_cast<unsigned int>(mStaging.size()));
+        mBuffer.update(mStaging.data(), static_cast<unsigned int>(mStaging.size()));
+        mBuffer.bindBase(LIGHT_BUFFER_BINDING);
+        mDirty = false;
+    }
+}
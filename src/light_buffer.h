@@ -0,0 +1,52 @@
+#pragma once
+#include <vector>
+#include "buffer_objects.h"
+#include "light.h"
+
+// Точка привязки буфера источников света (пространство GL_SHADER_STORAGE_BUFFER)
+constexpr GLuint LIGHT_BUFFER_BINDING = 0;
+
+// Список источников света в SSBO без ограничения на их число.
+// Буфер: число направленных, точечных и прожекторов, выравнивание до 16 байт,
+// затем массив GpuLight, отсортированный по типу в том же порядке.
+// Направленные шейдер обходит циклом, остальные - по спискам LightClusters.
+// Изменения копятся на CPU и уходят на GPU одной записью в upload().
+class LightBuffer {
+public:
+    size_t add(const Light& light);
+
+    // Изменяемый доступ помечает буфер как устаревший
+    Light& get(size_t index);
+
+    const Light& get(size_t index) const;
+
+    // Последний источник занимает место удалённого
+    void remove(size_t index);
+
+    void removeLast();
+
+    size_t size() const;
+
+    // Число источников данного типа - по нему выбирается вариант шейдера
+    int count(Light::Type type) const;
+
+    // Номера источников (как в get()) в порядке их записи в буфер; верен после upload()
+    const std::vector<uint32_t>& gpuOrder() const;
+
+    // Перезаливает буфер и привязывает его к LIGHT_BUFFER_BINDING, только если список менялся
+    void upload();
+
+private:
+    struct Header {
+        int32_t directionalCount;
+        int32_t pointCount;
+        int32_t spotCount;
+        int32_t padding;
+    };
+
+    std::vector<Light> mLights;
+    std::vector<uint32_t> mGpuOrder;
+    std::vector<unsigned char> mStaging;
+    SSBO mBuffer;
+    bool mDirty = true;
+};
@@ -0,0 +1,168 @@
+#include "light_clusters.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "gl_state_cache.h"
+#include "light_buffer.h"
+#include "thread_pool.h"
+
+void LightClusters::setProjection(float fovY, float aspect, float nearPlane, float farPlane) {
+    mNear = nearPlane;
+    mFar = farPlane;
+
+    // Границы срезов: near * (far / near)^(z / GRID_Z)
+    mSliceDepths.resize(GRID_Z + 1);
+    for (uint32_t z = 0; z <= GRID_Z; ++z) {
+        mSliceDepths[z] = mNear * std::pow(mFar / mNear, static_cast<float>(z) / GRID_Z);
+    }
+
+    // Кластер - усечённая пирамида; её AABB строится по восьми углам
+    const float tanY = std::tan(fovY * 0.5f);
+    const float tanX = tanY * aspect;
+    mBoxes.resize(CLUSTER_COUNT);
+    mSpheres.resize(CLUSTER_COUNT);
+    for (uint32_t z = 0; z < GRID_Z; ++z) {
+        for (uint32_t y = 0; y < GRID_Y; ++y) {
+            for (uint32_t x = 0; x < GRID_X; ++x) {
+                const float ndcX[2] = { -1.0f + 2.0f * x / GRID_X, -1.0f + 2.0f * (x + 1) / GRID_X };
+                const float ndcY[2] = { -1.0f + 2.0f * y / GRID_Y, -1.0f + 2.0f * (y + 1) / GRID_Y };
+                Aabb box;
+                for (float depth : { mSliceDepths[z], mSliceDepths[z + 1] }) {
+                    for (float cornerX : ndcX) {
+                        for (float cornerY : ndcY) {
+                            box.expand(glm::vec3(cornerX * tanX * depth, cornerY * tanY * depth, -depth));
+                        }
+                    }
+                }
+                const uint32_t cluster = x + GRID_X * (y + GRID_Y * z);
+                mBoxes[cluster] = box;
+                mSpheres[cluster] = { box.center(), glm::length(box.extents()) };
+            }
+        }
+    }
+
+    mSliceCounts.assign(GRID_Z, std::vector<uint32_t>(GRID_X * GRID_Y));
+    mSliceIndices.assign(GRID_Z, std::vector<uint32_t>());
+}
+
+float LightClusters::pointRange(float intensity, float constant, float linear, float quadratic) const {
+    // intensity / (c + l*d + q*d^2) = ATTENUATION_CUTOFF; intensity входит и в shade(), отсюда квадрат
+    const float limit = intensity * intensity / ATTENUATION_CUTOFF - constant;
+    if (limit <= 0.0f) return 0.0f;
+    if (quadratic > 0.0f) return (-linear + std::sqrt(linear * linear + 4.0f * quadratic * limit)) / (2.0f * quadratic);
+    if (linear > 0.0f) return limit / linear;
+    // Без затухания источник достаёт до дальней плоскости
+    return INFINITY;
+}
+
+void LightClusters::update(const LightBuffer& lights, const glm::mat4& view, int viewportWidth, int viewportHeight) {
+    if (mBoxes.empty()) return;
+
+    // Направленные источники шейдер обходит всегда, в кластеры идут только точечные и прожекторы
+    mViewLights.clear();
+    const std::vector<uint32_t>& gpuOrder = lights.gpuOrder();
+    for (uint32_t gpuIndex = 0; gpuIndex < gpuOrder.size(); ++gpuIndex) {
+        const Light& light = lights.get(gpuOrder[gpuIndex]);
+        if (light.type == static_cast<int>(Light::Type::Directional)) continue;
+
+        ViewLight viewLight;
+        viewLight.gpuIndex = gpuIndex;
+        viewLight.spot = light.type == static_cast<int>(Light::Type::Spot);
+        viewLight.position = glm::vec3(view * glm::vec4(light.position, 1.0f));
+        if (viewLight.spot) {
+            // Прожектор в шейдере не затухает - ограничен только конусом
+            viewLight.range = INFINITY;
+            viewLight.direction = glm::normalize(glm::vec3(view * glm::vec4(light.direction, 0.0f)));
+            viewLight.cosAngle = light.cutOff;
+            viewLight.sinAngle = std::sqrt(std::max(0.0f, 1.0f - light.cutOff * light.cutOff));
+        }
+        else {
+            viewLight.range = pointRange(light.intensity, light.constant, light.linear, light.quadratic);
+            if (viewLight.range <= 0.0f) continue;
+        }
+        viewLight.minDepth = -viewLight.position.z - viewLight.range;
+        viewLight.maxDepth = -viewLight.position.z + viewLight.range;
+        if (viewLight.maxDepth < mNear || viewLight.minDepth > mFar) continue;
+        mViewLights.push_back(viewLight);
+    }
+
+    ThreadPool::getInstance().parallelFor(GRID_Z, [this](uint32_t slice) { assignSlice(slice); });
+
+    // Срезы сливаются по порядку: сначала пары (начало, число), затем индексы
+    const uint32_t headerWords = sizeof(Header) / sizeof(uint32_t);
+    size_t total = 0;
+    for (const std::vector<uint32_t>& indices : mSliceIndices) total += indices.size();
+    mStaging.resize(headerWords + CLUSTER_COUNT * 2 + total);
+
+    const float sliceScale = GRID_Z / std::log(mFar / mNear);
+    Header header = {
+        { GRID_X, GRID_Y, GRID_Z, 0 },
+        { static_cast<float>(GRID_X) / std::max(viewportWidth, 1), static_cast<float>(GRID_Y) / std::max(viewportHeight, 1),
+            sliceScale, -sliceScale * std::log(mNear) }
+    };
+    std::memcpy(mStaging.data(), &header, sizeof(header));
+
+    mStats = { static_cast<uint32_t>(mViewLights.size()), static_cast<uint32_t>(total), 0 };
+    uint32_t* ranges = mStaging.data() + headerWords;
+    uint32_t offset = headerWords + CLUSTER_COUNT * 2;
+    for (uint32_t slice = 0; slice < GRID_Z; ++slice) {
+        const std::vector<uint32_t>& counts = mSliceCounts[slice];
+        const std::vector<uint32_t>& indices = mSliceIndices[slice];
+        std::copy(indices.begin(), indices.end(), mStaging.begin() + offset);
+        for (uint32_t tile = 0; tile < counts.size(); ++tile) {
+            *ranges++ = offset - headerWords;
+            *ranges++ = counts[tile];
+            offset += counts[tile];
+            mStats.maxPerCluster = std::max(mStats.maxPerCluster, counts[tile]);
+        }
+    }
+
+    if (mAlignment == 0) glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &mAlignment);
+    const unsigned int alignment = static_cast<unsigned int>(std::max(mAlignment, 4));
+    const unsigned int size = static_cast<unsigned int>(mStaging.size() * sizeof(uint32_t));
+    mBuffer.beginFrame(size + alignment);
+    const unsigned int bufferOffset = mBuffer.write(mStaging.data(), size, alignment);
+    GLStateCache::bindBufferRange(GL_SHADER_STORAGE_BUFFER, LIGHT_CLUSTER_BINDING, mBuffer.id(), bufferOffset, size);
+}
+
+void LightClusters::endFrame() {
+    mBuffer.endFrame();
+}
+
+void LightClusters::assignSlice(uint32_t slice) {
+    std::vector<uint32_t>& counts = mSliceCounts[slice];
+    std::vector<uint32_t>& indices = mSliceIndices[slice];
+    std::fill(counts.begin(), counts.end(), 0);
+    indices.clear();
+
+    const float sliceNear = mSliceDepths[slice];
+    const float sliceFar = mSliceDepths[slice + 1];
+    for (uint32_t tile = 0; tile < GRID_X * GRID_Y; ++tile) {
+        const uint32_t cluster = tile + GRID_X * GRID_Y * slice;
+        for (const ViewLight& light : mViewLights) {
+            if (light.maxDepth < sliceNear || light.minDepth > sliceFar) continue;
+
+            if (light.spot) {
+                // Конус против описанной сферы кластера: угол, дальность и задняя полуплоскость
+                const BoundingSphere& sphere = mSpheres[cluster];
+                const glm::vec3 toCenter = sphere.center - light.position;
+                const float lengthSquared = glm::dot(toCenter, toCenter);
+                const float along = glm::dot(toCenter, light.direction);
+                const float across = std::sqrt(std::max(0.0f, lengthSquared - along * along));
+                if (light.cosAngle * across - along * light.sinAngle > sphere.radius) continue;
+                if (along > sphere.radius + light.range) continue;
+                if (light.cosAngle >= 0.0f && along < -sphere.radius) continue;
+            }
+            else if (mBoxes[cluster].distanceSquared(light.position) > light.range * light.range) {
+                continue;
+            }
+
+            indices.push_back(light.gpuIndex);
+            ++counts[tile];
+        }
+    }
+}
+
+const LightClusters::Stats& LightClusters::stats() const {
+    return mStats;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+#include "dynamic_ring_buffer.h"
+
+class LightBuffer;
+
+// Точка привязки буфера кластеров (пространство GL_SHADER_STORAGE_BUFFER)
+constexpr GLuint LIGHT_CLUSTER_BINDING = 2;
+
+// Кластерное прямое освещение. Пирамида видимости делится на сетку
+// GRID_X x GRID_Y тайлов экрана и GRID_Z срезов по глубине (срезы растут
+// экспоненциально, как и перспективная ошибка). Точечные источники
+// проверяются сферой действия, прожекторы - конусом; списки источников
+// для каждого кластера собираются на CPU параллельно по срезам.
+// Буфер (std430, как LightClusterBuffer в f_lighting.glsl): размеры сетки,
+// масштабы для перевода gl_FragCoord и глубины в номер кластера, затем
+// пары (начало, число) для каждого кластера и сами индексы в lights[].
+class LightClusters {
+public:
+    static constexpr uint32_t GRID_X = 16;
+    static constexpr uint32_t GRID_Y = 9;
+    static constexpr uint32_t GRID_Z = 24;
+    static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    // Вклад ниже этой доли считается нулевым - по нему ограничивается радиус точечного источника
+    static constexpr float ATTENUATION_CUTOFF = 1.0f / 256.0f;
+
+    struct Stats {
+        uint32_t lights = 0;
+        uint32_t references = 0;
+        uint32_t maxPerCluster = 0;
+    };
+
+    // Пересчитывает границы кластеров в пространстве вида; параметры - как у glm::perspective
+    void setProjection(float fovY, float aspect, float nearPlane, float farPlane);
+
+    // Распределяет источники по кластерам и заливает буфер. Вызывается после
+    // lights.upload(), так как индексы ссылаются на порядок источников в его буфере
+    void update(const LightBuffer& lights, const glm::mat4& view, int viewportWidth, int viewportHeight);
+
+    // После последней отрисовки кадра: область буфера кадра можно будет переписать, когда GPU её дочитает
+    void endFrame();
+
+    // Счётчики с последнего update()
+    const Stats& stats() const;
+
+private:
+    // Источник в пространстве вида, подготовленный к проверкам
+    struct ViewLight {
+        uint32_t gpuIndex;
+        bool spot;
+        glm::vec3 position;
+        float range;
+        glm::vec3 direction;
+        float cosAngle;
+        float sinAngle;
+        float minDepth;
+        float maxDepth;
+    };
+
+    struct Header {
+        uint32_t grid[4];
+        float scale[4];
+    };
+
+    // Радиус, за которым вклад точечного источника меньше ATTENUATION_CUTOFF
+    float pointRange(float intensity, float constant, float linear, float quadratic) const;
+
+    // Собирает списки одного среза: mSliceCounts/mSliceIndices[slice]
+    void assignSlice(uint32_t slice);
+
+    float mNear = 0.1f;
+    float mFar = 100.0f;
+    std::vector<Aabb> mBoxes;
+    std::vector<BoundingSphere> mSpheres;
+    std::vector<float> mSliceDepths;
+
+    std::vector<ViewLight> mViewLights;
+    std::vector<std::vector<uint32_t>> mSliceCounts;
+    std::vector<std::vector<uint32_t>> mSliceIndices;
+    std::vector<uint32_t> mStaging;
+    DynamicRingBuffer mBuffer;
+    GLint mAlignment = 0;
+    Stats mStats;
+};
@@ -0,0 +1,128 @@
+#include "load_profiler.h"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+static thread_local std::string currentAsset = "<unnamed>";
+
+static uint32_t currentThreadId() {
+    return static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()) & 0xFFFF);
+}
+
+static std::string escapeJson(const std::string& text) {
+    std::string result;
+    result.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        result += c;
+    }
+    return result;
+}
+
+LoadProfiler::AssetScope::AssetScope(const std::string& asset) : mPrevious(currentAsset), mStart(Clock::now()) {
+    currentAsset = asset;
+}
+
+LoadProfiler::AssetScope::~AssetScope() {
+    LoadProfiler::getInstance().record(currentAsset, Phase::Total, mStart, Clock::now());
+    currentAsset = mPrevious;
+}
+
+LoadProfiler::Scope::Scope(Phase phase) : mPhase(phase), mStart(Clock::now()) {}
+
+LoadProfiler::Scope::~Scope() {
+    LoadProfiler::getInstance().record(currentAsset, mPhase, mStart, Clock::now());
+}
+
+LoadProfiler& LoadProfiler::getInstance() {
+    static LoadProfiler instance;
+    return instance;
+}
+
+const char* LoadProfiler::phaseName(Phase phase) {
+    switch (phase) {
+    case Phase::FileRead: return "read";
+    case Phase::Parse: return "parse";
+    case Phase::Decode: return "decode";
+    case Phase::Upload: return "upload";
+    case Phase::Compile: return "compile";
+    case Phase::Link: return "link";
+    case Phase::CacheLoad: return "cache";
+    case Phase::Total: return "total";
+    default: return "?";
+    }
+}
+
+void LoadProfiler::record(const std::string& asset, Phase phase, Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.push_back({ asset, phase, start, end, currentThreadId() });
+}
+
+bool LoadProfiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        Logger::error_log("Could not write load trace '" + path + "'");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Отсчёт времени - от начала самого раннего события
+    Clock::time_point origin = mEvents.empty() ? Clock::now() : mEvents.front().start;
+    for (const Event& e : mEvents) origin = std::min(origin, e.start);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < mEvents.size(); ++i) {
+        const Event& e = mEvents[i];
+        const auto ts = std::chrono::duration_cast<std::chrono::microseconds>(e.start - origin).count();
+        const auto dur = std::chrono::duration_cast<std::chrono::microseconds>(e.end - e.start).count();
+        const std::string name = escapeJson(e.asset);
+        out << (i ? ",\n" : "\n")
+            << "{\"name\":\"" << (e.phase == Phase::Total ? name : name + " " + phaseName(e.phase))
+            << "\",\"cat\":\"" << phaseName(e.phase)
+            << "\",\"ph\":\"X\",\"ts\":" << ts << ",\"dur\":" << dur
+            << ",\"pid\":1,\"tid\":" << e.thread
+            << ",\"args\":{\"asset\":\"" << name << "\"}}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void LoadProfiler::printSummary(std::ostream& out, size_t maxRows) const {
+    constexpr size_t PHASES = static_cast<size_t>(Phase::Count);
+    std::map<std::string, std::array<double, PHASES>> perAsset;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (const Event& e : mEvents) {
+            auto& row = perAsset.try_emplace(e.asset).first->second;
+            row[static_cast<size_t>(e.phase)] += std::chrono::duration<double, std::milli>(e.end - e.start).count();
+        }
+    }
+
+    std::vector<std::pair<std::string, std::array<double, PHASES>>> rows(perAsset.begin(), perAsset.end());
+    const size_t total = static_cast<size_t>(Phase::Total);
+    std::sort(rows.begin(), rows.end(), [total](const auto& a, const auto& b) { return a.second[total] > b.second[total]; });
+    if (maxRows != 0 && rows.size() > maxRows) rows.resize(maxRows);
+
+    out << std::left << std::setw(28) << "asset";
+    for (size_t p = 0; p < PHASES; ++p) out << std::right << std::setw(10) << phaseName(static_cast<Phase>(p));
+    out << "   (ms)" << std::endl;
+    out << std::fixed << std::setprecision(2);
+    for (const auto& row : rows) {
+        out << std::left << std::setw(28) << row.first;
+        for (size_t p = 0; p < PHASES; ++p) out << std::right << std::setw(10) << row.second[p];
+        out << std::endl;
+    }
+    out << std::defaultfloat;
+}
+
+void LoadProfiler::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.clear();
+}
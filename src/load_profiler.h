@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Профилировщик загрузки ресурсов. Замеряет фазы загрузки каждого ресурса
+// и выводит их в формате Chrome trace (chrome://tracing, Perfetto) и сводной таблицей.
+//
+//   LoadProfiler::AssetScope asset("tree");              // чей это ресурс
+//   LoadProfiler::Scope scope(LoadProfiler::Phase::Parse); // что именно делаем
+class LoadProfiler {
+public:
+    enum class Phase {
+        FileRead,
+        Parse,
+        Decode,
+        Upload,
+        Compile,
+        Link,
+        CacheLoad,
+        Total,
+        Count
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string asset;
+        Phase phase;
+        Clock::time_point start;
+        Clock::time_point end;
+        uint32_t thread;
+    };
+
+    // Задаёт имя текущего ресурса для вложенных Scope в этом потоке
+    class AssetScope {
+    public:
+        explicit AssetScope(const std::string& asset);
+        ~AssetScope();
+        AssetScope(const AssetScope&) = delete;
+        AssetScope& operator=(const AssetScope&) = delete;
+    private:
+        std::string mPrevious;
+        Clock::time_point mStart;
+    };
+
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        Phase mPhase;
+        Clock::time_point mStart;
+    };
+
+    static LoadProfiler& getInstance();
+
+    static const char* phaseName(Phase phase);
+
+    void record(const std::string& asset, Phase phase, Clock::time_point start, Clock::time_point end);
+
+    bool writeChromeTrace(const std::string& path) const;
+
+    // Таблица по ресурсам, отсортированная по суммарному времени (самые медленные сверху)
+    void printSummary(std::ostream& out = std::cout, size_t maxRows = 0) const;
+
+    void clear();
+
+private:
+    LoadProfiler() = default;
+
+    mutable std::mutex mMutex;
+    std::vector<Event> mEvents;
+};
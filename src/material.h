@@ -1,4 +1,9 @@
+#pragma once
 #include"mesh.h"
+#include <cstdint>
+
+// Индекс материала в MaterialRegistry
+using MaterialId = uint32_t;
 
 struct Material {
 	glm::vec3 diffuseColor;
@@ -6,4 +11,18 @@ struct Material {
 	glm::vec3 emissionColor;
 	glm::vec3 ambientColor;
 	float shininess;
-};
\ No newline at end of file
+};
+
+// Материал в буфере MaterialBuffer, раскладка std430 - как у struct Material в f_lighting.glsl
+struct GpuMaterial {
+	glm::vec3 diffuseColor;
+	float shininess;
+	glm::vec3 specularColor;
+	float padding0;
+	glm::vec3 emissionColor;
+	float padding1;
+	glm::vec3 ambientColor;
+	float padding2;
+};
+
+static_assert(sizeof(GpuMaterial) == 64, "GpuMaterial must match the std430 layout of the shader struct");
@@ -0,0 +1,37 @@
+#include "material_registry.h"
+
+MaterialId MaterialRegistry::add(const Material& material) {
+    mMaterials.push_back(material);
+    mDirty = true;
+    return static_cast<MaterialId>(mMaterials.size() - 1);
+}
+
+Material& MaterialRegistry::get(MaterialId id) {
+    mDirty = true;
+    return mMaterials[id];
+}
+
+const Material& MaterialRegistry::get(MaterialId id) const {
+    return mMaterials[id];
+}
+
+size_t MaterialRegistry::size() const {
+    return mMaterials.size();
+}
+
+void MaterialRegistry::upload() {
+    if (!mDirty) return;
+
+    mStaging.resize(mMaterials.size());
+    for (size_t i = 0; i < mMaterials.size(); ++i) {
+        const Material& material = mMaterials[i];
+        mStaging[i] = { material.diffuseColor, material.shininess, material.specularColor, 0.0f,
+            material.emissionColor, 0.0f, material.ambientColor, 0.0f };
+    }
+
+    const unsigned int size = static_cast<unsigned int>(mStaging.size() * sizeof(GpuMaterial));
+    mBuffer.reserve(size);
+    if (size > 0) mBuffer.update(mStaging.data(), size);
+    mBuffer.bindBase(MATERIAL_BUFFER_BINDING);
+    mDirty = false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include "buffer_objects.h"
+#include "material.h"
+
+// Точка привязки буфера материалов (пространство GL_SHADER_STORAGE_BUFFER)
+constexpr GLuint MATERIAL_BUFFER_BINDING = 1;
+
+// Все материалы сцены в одном SSBO. Объект хранит только индекс материала,
+// и при отрисовке передаётся лишь он, а не поля материала по отдельности.
+class MaterialRegistry {
+public:
+    MaterialId add(const Material& material);
+
+    // Изменяемый доступ помечает буфер как устаревший
+    Material& get(MaterialId id);
+
+    const Material& get(MaterialId id) const;
+
+    size_t size() const;
+
+    // Перезаливает буфер и привязывает его к MATERIAL_BUFFER_BINDING, только если материалы менялись
+    void upload();
+
+private:
+    std::vector<Material> mMaterials;
+    std::vector<GpuMaterial> mStaging;
+    SSBO mBuffer;
+    bool mDirty = true;
+};
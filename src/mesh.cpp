@@ -1,4 +1,10 @@
 #include "mesh.h"
+#include "load_profiler.h"
+#include "hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
 
 std::vector<std::string> split(const std::string& s, const char delimiter) {
     size_t pos_start = 0, pos_end;
@@ -24,47 +30,63 @@ std::vector<std::string> split(const std::string& s, const char delimiter) {
 Mesh::Mesh(const char* meshPath)
 {
     parseFile(meshPath);
+    buildIndices();
+    computeBounds();
+    InitPositionBuffers();
+}
+
+Mesh::Mesh(std::string_view objData, const std::string& name)
+{
+    parse(objData, name);
+    buildIndices();
+    computeBounds();
     InitPositionBuffers();
 }
 Mesh::~Mesh() {
-    if (glIsBuffer(VBO)) {
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glDeleteBuffers(1, &VBO);
-    }
-    if (glIsVertexArray(VAO)) {
-        glBindVertexArray(0);
-        glDeleteVertexArrays(1, &VAO);
-    }
+    GeometryPool::getInstance().release(range);
 }
 
 Mesh& Mesh::operator=(Mesh&& mesh) noexcept {
     if (this != &mesh) {
+        GeometryPool::getInstance().release(range);
         vertices = std::move(mesh.vertices);
-        VBO = mesh.VBO;
-        VAO = mesh.VAO;
-        mesh.VBO = 0;
-        mesh.VAO = 0;
+        indices = std::move(mesh.indices);
+        range = mesh.range;
+        bounds = mesh.bounds;
+        sphere = mesh.sphere;
+        mesh.range = GeometryPool::Range();
     }
     return *this;
 }
 
 Mesh::Mesh(Mesh&& mesh) noexcept {
     vertices = std::move(mesh.vertices);
-    VBO = mesh.VBO;
-    VAO = mesh.VAO;
-    mesh.VBO = 0;
-    mesh.VAO = 0;
+    indices = std::move(mesh.indices);
+    range = mesh.range;
+    bounds = mesh.bounds;
+    sphere = mesh.sphere;
+    mesh.range = GeometryPool::Range();
 }
 
 void Mesh::parseFile(const std::string& filePath)
 {
-    try {
-        std::ifstream obj(filePath);
-
+    std::string data;
+    {
+        LoadProfiler::Scope profile(LoadProfiler::Phase::FileRead);
+        std::ifstream obj(filePath, std::ios::binary);
         if (!obj.is_open()) {
-            throw std::exception("File cannot be opened");
+            std::cout << filePath << ": File cannot be opened" << std::endl;
+            return;
         }
+        data.assign((std::istreambuf_iterator<char>(obj)), std::istreambuf_iterator<char>());
+    }
+    parse(data, filePath);
+}
 
+void Mesh::parse(std::string_view data, const std::string& name)
+{
+    LoadProfiler::Scope profile(LoadProfiler::Phase::Parse);
+    try {
         std::vector<std::vector<float>> v, vt, vn;
         std::string line;
 
@@ -81,7 +103,14 @@ void Mesh::parseFile(const std::string& filePath)
             return values;
         };
 
-        while (std::getline(obj, line)) {
+        size_t lineStart = 0;
+        while (lineStart < data.size()) {
+            size_t lineEnd = data.find('\n', lineStart);
+            if (lineEnd == std::string_view::npos) lineEnd = data.size();
+            line.assign(data.data() + lineStart, lineEnd - lineStart);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            lineStart = lineEnd + 1;
+
             iss.str(line);
             std::string type;
             iss >> type;
@@ -124,7 +153,7 @@ void Mesh::parseFile(const std::string& filePath)
             }
             iss.clear();
         }
-        std::cout << filePath << " has been loaded. Total vertices: " << vertices.size() << std::endl;
+        std::cout << name << " has been loaded. Total vertices: " << vertices.size() << std::endl;
         return;
     }
     catch (const std::exception& e) {
@@ -132,24 +161,52 @@ void Mesh::parseFile(const std::string& filePath)
     }
 }
 
-void Mesh::InitPositionBuffers()
+void Mesh::buildIndices()
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), vertices.data(), GL_STATIC_DRAW);
-
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid*)offsetof(MeshVertex, position));
-
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid*)offsetof(MeshVertex, normal));
+    struct VertexHash {
+        size_t operator()(const MeshVertex& vertex) const {
+            return static_cast<size_t>(fnv1a64(reinterpret_cast<const char*>(&vertex), sizeof(MeshVertex)));
+        }
+    };
+    struct VertexEqual {
+        bool operator()(const MeshVertex& a, const MeshVertex& b) const {
+            return std::memcmp(&a, &b, sizeof(MeshVertex)) == 0;
+        }
+    };
+
+    std::unordered_map<MeshVertex, uint32_t, VertexHash, VertexEqual> unique;
+    unique.reserve(vertices.size());
+    std::vector<MeshVertex> uniqueVertices;
+    indices.clear();
+    indices.reserve(vertices.size());
+    for (const MeshVertex& vertex : vertices) {
+        auto [it, inserted] = unique.emplace(vertex, static_cast<uint32_t>(uniqueVertices.size()));
+        if (inserted) uniqueVertices.push_back(vertex);
+        indices.push_back(it->second);
+    }
+    vertices = std::move(uniqueVertices);
+}
 
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid*)offsetof(MeshVertex, texture));
+void Mesh::computeBounds()
+{
+    bounds = Aabb();
+    for (const MeshVertex& vertex : vertices) {
+        bounds.expand(glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]));
+    }
+    if (!bounds.isValid()) return;
+
+    // Центр - центр AABB, радиус - до самой дальней вершины (не больше половины диагонали)
+    sphere.center = bounds.center();
+    float radiusSquared = 0.0f;
+    for (const MeshVertex& vertex : vertices) {
+        const glm::vec3 offset = glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]) - sphere.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    sphere.radius = std::sqrt(radiusSquared);
+}
 
-    glBindVertexArray(0);
-}
\ No newline at end of file
+void Mesh::InitPositionBuffers()
+{
+    LoadProfiler::Scope profile(LoadProfiler::Phase::Upload);
+    range = GeometryPool::getInstance().allocate(vertices, indices);
+}
@@ -1,8 +1,11 @@
 #pragma once
 #include "texture.h"
+#include "geometry_pool.h"
+#include "bounds.h"
 #include <array>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -10,21 +13,25 @@
 
 std::vector<std::string> split(const std::string& s, const char delimiter);
 
-struct MeshVertex {
-    GLfloat position[3];
-    GLfloat normal[3];
-    GLfloat texture[2];
-};
-
 class Mesh{
 private:
     void parseFile(const std::string& filePath);
+    void parse(std::string_view data, const std::string& name);
+    // Склеивает одинаковые вершины развёрнутого .obj и строит индексы
+    void buildIndices();
+    void computeBounds();
     void InitPositionBuffers();
 public:
     std::vector<MeshVertex> vertices;
-    GLuint VBO;
-    GLuint VAO;
+    std::vector<uint32_t> indices;
+    // Место меша в общем GeometryPool
+    GeometryPool::Range range;
+    // Границы в пространстве модели, считаются при загрузке
+    Aabb bounds;
+    BoundingSphere sphere;
     Mesh(const char* meshPath);
+    // Разбор .obj прямо из памяти (например, из отображённого пакета ресурсов)
+    Mesh(std::string_view objData, const std::string& name);
 
     ~Mesh();
 
@@ -0,0 +1,283 @@
+#include "occlusion_culler.h"
+#include <algorithm>
+#include <cmath>
+#include "mesh.h"
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+// Вершин на одну задачу при переводе окклюдеров в пространство отсечения
+static constexpr uint32_t TRANSFORM_CHUNK = 4096;
+
+// Сдвиг рёбер треугольника наружу, в пикселях
+static constexpr float EDGE_BIAS = 0.01f;
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height)
+    : mWidth((width + 3) & ~3u), mHeight((height + BAND_HEIGHT - 1) / BAND_HEIGHT * BAND_HEIGHT) {
+    uint32_t levelWidth = mWidth;
+    uint32_t levelHeight = mHeight;
+    for (;;) {
+        mLevels.push_back({ levelWidth, levelHeight, std::vector<float>(size_t(levelWidth) * levelHeight, 1.0f) });
+        if (levelWidth == 1 && levelHeight == 1) break;
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+}
+
+void OcclusionCuller::addOccluder(const Mesh& mesh, const glm::mat4& model) {
+    const uint32_t base = static_cast<uint32_t>(mOccluderVertices.size());
+    for (const MeshVertex& vertex : mesh.vertices) {
+        const glm::vec4 position(vertex.position[0], vertex.position[1], vertex.position[2], 1.0f);
+        mOccluderVertices.push_back(glm::vec3(model * position));
+    }
+    for (uint32_t index : mesh.indices) mOccluderIndices.push_back(base + index);
+}
+
+void OcclusionCuller::clearOccluders() {
+    mOccluderVertices.clear();
+    mOccluderIndices.clear();
+}
+
+void OcclusionCuller::render(const glm::mat4& viewProjection) {
+    mViewProjection = viewProjection;
+    mStats = Stats();
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    const uint32_t vertexCount = static_cast<uint32_t>(mOccluderVertices.size());
+    mClipVertices.resize(vertexCount);
+    pool.parallelFor((vertexCount + TRANSFORM_CHUNK - 1) / TRANSFORM_CHUNK, [&](uint32_t chunk) {
+        const uint32_t end = std::min(vertexCount, (chunk + 1) * TRANSFORM_CHUNK);
+        for (uint32_t i = chunk * TRANSFORM_CHUNK; i < end; ++i) {
+            mClipVertices[i] = viewProjection * glm::vec4(mOccluderVertices[i], 1.0f);
+        }
+    });
+
+    mTriangles.clear();
+    for (size_t i = 0; i + 2 < mOccluderIndices.size(); i += 3) {
+        setupTriangle(mClipVertices[mOccluderIndices[i]], mClipVertices[mOccluderIndices[i + 1]],
+            mClipVertices[mOccluderIndices[i + 2]]);
+    }
+    mStats.triangles = static_cast<uint32_t>(mTriangles.size());
+
+    // Полосы не пересекаются по пикселям, поэтому потоки пишут без синхронизации
+    pool.parallelFor(mHeight / BAND_HEIGHT, [this](uint32_t band) { rasterizeBand(band); });
+    buildPyramid();
+}
+
+void OcclusionCuller::setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    // Целиком за одной из боковых плоскостей - не виден
+    for (int axis = 0; axis < 2; ++axis) {
+        if (a[axis] > a.w && b[axis] > b.w && c[axis] > c.w) return;
+        if (a[axis] < -a.w && b[axis] < -b.w && c[axis] < -c.w) return;
+    }
+
+    // Ближняя плоскость: z + w >= 0
+    const glm::vec4 input[3] = { a, b, c };
+    float distance[3];
+    int insideCount = 0;
+    for (int i = 0; i < 3; ++i) {
+        distance[i] = input[i].z + input[i].w;
+        if (distance[i] >= 0.0f) ++insideCount;
+    }
+    if (insideCount == 0) return;
+    if (insideCount == 3) {
+        emitTriangle(a, b, c);
+        return;
+    }
+
+    // Отсечение Сазерленда-Ходжмена по одной плоскости: не больше четырёх вершин
+    glm::vec4 polygon[4];
+    int count = 0;
+    for (int i = 0; i < 3; ++i) {
+        const int next = (i + 1) % 3;
+        if (distance[i] >= 0.0f) polygon[count++] = input[i];
+        if ((distance[i] >= 0.0f) != (distance[next] >= 0.0f)) {
+            const float t = distance[i] / (distance[i] - distance[next]);
+            polygon[count++] = input[i] + (input[next] - input[i]) * t;
+        }
+    }
+    for (int i = 1; i + 1 < count; ++i) emitTriangle(polygon[0], polygon[i], polygon[i + 1]);
+}
+
+void OcclusionCuller::emitTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c) {
+    const glm::vec4 clip[3] = { a, b, c };
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; ++i) {
+        if (clip[i].w <= 0.0f) return;
+        const float inverseW = 1.0f / clip[i].w;
+        x[i] = (clip[i].x * inverseW * 0.5f + 0.5f) * mWidth;
+        y[i] = (clip[i].y * inverseW * 0.5f + 0.5f) * mHeight;
+        z[i] = clip[i].z * inverseW * 0.5f + 0.5f;
+    }
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0f) return;
+    // Обход против часовой стрелки: внутри все рёбра неотрицательны
+    if (area < 0.0f) {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    ScreenTriangle triangle;
+    // Покрываются пиксели, чьи центры (i + 0.5) попали в треугольник
+    const float minX = std::min({ x[0], x[1], x[2] });
+    const float maxX = std::max({ x[0], x[1], x[2] });
+    const float minY = std::min({ y[0], y[1], y[2] });
+    const float maxY = std::max({ y[0], y[1], y[2] });
+    triangle.minX = std::max(0, static_cast<int32_t>(std::ceil(minX - 0.5f)));
+    triangle.maxX = std::min(static_cast<int32_t>(mWidth) - 1, static_cast<int32_t>(std::floor(maxX - 0.5f)));
+    triangle.minY = std::max(0, static_cast<int32_t>(std::ceil(minY - 0.5f)));
+    triangle.maxY = std::min(static_cast<int32_t>(mHeight) - 1, static_cast<int32_t>(std::floor(maxY - 0.5f)));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+    // Ребро i лежит напротив вершины i и даёт её барицентрическую координату
+    const float inverseArea = 1.0f / area;
+    triangle.depthA = triangle.depthB = triangle.depthC = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        const int from = (i + 1) % 3;
+        const int to = (i + 2) % 3;
+        triangle.edgeA[i] = y[from] - y[to];
+        triangle.edgeB[i] = x[to] - x[from];
+        triangle.edgeC[i] = -(triangle.edgeA[i] * x[from] + triangle.edgeB[i] * y[from]);
+
+        triangle.depthA += triangle.edgeA[i] * inverseArea * z[i];
+        triangle.depthB += triangle.edgeB[i] * inverseArea * z[i];
+        triangle.depthC += triangle.edgeC[i] * inverseArea * z[i];
+    }
+    // Рёбра сдвигаются наружу на долю пикселя: у длинных треугольников (окклюдер
+    // у самой камеры) ошибка округления иначе оставляет щель вдоль общего ребра
+    for (int i = 0; i < 3; ++i) {
+        triangle.edgeC[i] += EDGE_BIAS * std::sqrt(triangle.edgeA[i] * triangle.edgeA[i] + triangle.edgeB[i] * triangle.edgeB[i]);
+    }
+    mTriangles.push_back(triangle);
+}
+
+void OcclusionCuller::rasterizeBand(uint32_t band) {
+    std::vector<float>& depth = mLevels[0].depth;
+    const int32_t bandMinY = static_cast<int32_t>(band * BAND_HEIGHT);
+    const int32_t bandMaxY = bandMinY + static_cast<int32_t>(BAND_HEIGHT) - 1;
+    std::fill(depth.begin() + size_t(bandMinY) * mWidth, depth.begin() + size_t(bandMaxY + 1) * mWidth, 1.0f);
+
+    for (const ScreenTriangle& triangle : mTriangles) {
+        const int32_t minY = std::max(triangle.minY, bandMinY);
+        const int32_t maxY = std::min(triangle.maxY, bandMaxY);
+        if (minY > maxY) continue;
+        const int32_t startX = triangle.minX & ~3;
+
+#ifdef OCCLUSION_CULLER_SSE
+        const __m128 laneOffset = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 edgeA0 = _mm_set1_ps(triangle.edgeA[0]);
+        const __m128 edgeA1 = _mm_set1_ps(triangle.edgeA[1]);
+        const __m128 edgeA2 = _mm_set1_ps(triangle.edgeA[2]);
+        const __m128 depthA = _mm_set1_ps(triangle.depthA);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int32_t y = minY; y <= maxY; ++y) {
+            const float centerY = y + 0.5f;
+            const __m128 row0 = _mm_set1_ps(triangle.edgeB[0] * centerY + triangle.edgeC[0]);
+            const __m128 row1 = _mm_set1_ps(triangle.edgeB[1] * centerY + triangle.edgeC[1]);
+            const __m128 row2 = _mm_set1_ps(triangle.edgeB[2] * centerY + triangle.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(triangle.depthB * centerY + triangle.depthC);
+            float* rowPixels = depth.data() + size_t(y) * mWidth;
+
+            for (int32_t x = startX; x <= triangle.maxX; x += 4) {
+                const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffset);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA0, centerX), row0), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA1, centerX), row1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeA2, centerX), row2), zero));
+                if (_mm_movemask_ps(inside) == 0) continue;
+
+                const __m128 fragmentDepth = _mm_add_ps(_mm_mul_ps(depthA, centerX), rowDepth);
+                const __m128 old = _mm_loadu_ps(rowPixels + x);
+                const __m128 nearer = _mm_min_ps(old, fragmentDepth);
+                _mm_storeu_ps(rowPixels + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+        }
+#else
+        for (int32_t y = minY; y <= maxY; ++y) {
+            const float centerY = y + 0.5f;
+            float* rowPixels = depth.data() + size_t(y) * mWidth;
+            for (int32_t x = startX; x <= triangle.maxX; ++x) {
+                const float centerX = x + 0.5f;
+                bool inside = true;
+                for (int i = 0; i < 3; ++i) {
+                    inside = inside && triangle.edgeA[i] * centerX + triangle.edgeB[i] * centerY + triangle.edgeC[i] >= 0.0f;
+                }
+                if (!inside) continue;
+                const float fragmentDepth = triangle.depthA * centerX + triangle.depthB * centerY + triangle.depthC;
+                rowPixels[x] = std::min(rowPixels[x], fragmentDepth);
+            }
+        }
+#endif
+    }
+}
+
+void OcclusionCuller::buildPyramid() {
+    for (size_t level = 1; level < mLevels.size(); ++level) {
+        const Level& source = mLevels[level - 1];
+        Level& target = mLevels[level];
+        for (uint32_t y = 0; y < target.height; ++y) {
+            const uint32_t y0 = y * 2;
+            const uint32_t y1 = std::min(y0 + 1, source.height - 1);
+            for (uint32_t x = 0; x < target.width; ++x) {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, source.width - 1);
+                target.depth[size_t(y) * target.width + x] = std::max(
+                    std::max(source.depth[size_t(y0) * source.width + x0], source.depth[size_t(y0) * source.width + x1]),
+                    std::max(source.depth[size_t(y1) * source.width + x0], source.depth[size_t(y1) * source.width + x1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const Aabb& worldBox) {
+    ++mStats.tested;
+
+    float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner) {
+        const glm::vec4 position((corner & 1) ? worldBox.max.x : worldBox.min.x, (corner & 2) ? worldBox.max.y : worldBox.min.y,
+            (corner & 4) ? worldBox.max.z : worldBox.min.z, 1.0f);
+        const glm::vec4 clip = mViewProjection * position;
+        // Пересекает ближнюю плоскость - камера рядом или внутри, не отсекаем
+        if (clip.w <= 0.0f || clip.z < -clip.w) return true;
+
+        const float inverseW = 1.0f / clip.w;
+        const float x = (clip.x * inverseW * 0.5f + 0.5f) * mWidth;
+        const float y = (clip.y * inverseW * 0.5f + 0.5f) * mHeight;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip.z * inverseW * 0.5f + 0.5f);
+    }
+    // Вне экрана решает отсечение по пирамиде видимости
+    if (maxX < 0.0f || maxY < 0.0f || minX >= mWidth || minY >= mHeight) return true;
+
+    const uint32_t x0 = static_cast<uint32_t>(std::max(0.0f, minX));
+    const uint32_t y0 = static_cast<uint32_t>(std::max(0.0f, minY));
+    const uint32_t x1 = std::min(mWidth - 1, static_cast<uint32_t>(maxX));
+    const uint32_t y1 = std::min(mHeight - 1, static_cast<uint32_t>(maxY));
+
+    // Уровень, на котором прямоугольник укладывается в 2x2 текселя
+    size_t level = 0;
+    while (level + 1 < mLevels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) ++level;
+
+    const Level& pyramid = mLevels[level];
+    for (uint32_t y = y0 >> level; y <= (y1 >> level); ++y) {
+        for (uint32_t x = x0 >> level; x <= (x1 >> level); ++x) {
+            // Хоть где-то окклюдер дальше ближней точки объекта - объект может быть виден
+            if (pyramid.depth[size_t(y) * pyramid.width + x] >= minZ) return true;
+        }
+    }
+    ++mStats.occluded;
+    return false;
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::stats() const {
+    return mStats;
+}
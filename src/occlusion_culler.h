@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+
+class Mesh;
+
+// Программное отсечение перекрытых объектов. Несколько крупных окклюдеров
+// (рельеф, здания - их упрощённые меши) растеризуются на CPU в буфер глубины
+// низкого разрешения: полосы экрана делятся между потоками ThreadPool, в строке
+// обрабатывается по 4 пикселя за раз (SSE). По буферу строится пирамида
+// максимальной глубины, и AABB объекта проверяется по одному её уровню,
+// где проекция занимает не больше пары текселей.
+class OcclusionCuller {
+public:
+    struct Stats {
+        uint32_t triangles = 0;
+        uint32_t tested = 0;
+        uint32_t occluded = 0;
+    };
+
+    // Ширина кратна 4, высота - высоте полосы
+    static constexpr uint32_t BAND_HEIGHT = 8;
+
+    OcclusionCuller(uint32_t width = 256, uint32_t height = 192);
+
+    // Треугольники меша копируются в мировых координатах. Подвижный окклюдер
+    // придётся удалить и добавить заново
+    void addOccluder(const Mesh& mesh, const glm::mat4& model);
+
+    void clearOccluders();
+
+    // Растеризует окклюдеры с этой камеры и строит пирамиду глубины
+    void render(const glm::mat4& viewProjection);
+
+    // false - AABB (в мировых координатах) гарантированно закрыт окклюдерами
+    bool isVisible(const Aabb& worldBox);
+
+    // Счётчики с последнего render()
+    const Stats& stats() const;
+
+private:
+    // Треугольник в экранных координатах, заданный аффинными функциями пикселя:
+    // рёбра edge*[i] неотрицательны внутри, глубина линейна в экранном пространстве
+    struct ScreenTriangle {
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        float depthA;
+        float depthB;
+        float depthC;
+        int32_t minX;
+        int32_t maxX;
+        int32_t minY;
+        int32_t maxY;
+    };
+
+    // Переводит треугольник из пространства отсечения в экранный, отрезая часть за ближней плоскостью
+    void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+    void emitTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+    void rasterizeBand(uint32_t band);
+
+    void buildPyramid();
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    glm::mat4 mViewProjection = glm::mat4(1.0f);
+
+    std::vector<glm::vec3> mOccluderVertices;
+    std::vector<uint32_t> mOccluderIndices;
+
+    std::vector<glm::vec4> mClipVertices;
+    std::vector<ScreenTriangle> mTriangles;
+
+    // Уровень 0 - сам буфер глубины [0, 1], дальше - максимум по 2x2
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        std::vector<float> depth;
+    };
+    std::vector<Level> mLevels;
+
+    Stats mStats;
+};
@@ -0,0 +1,107 @@
+#include "program_binary_cache.h"
+#include "hash.h"
+#include "logger.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+    constexpr char BINARY_MAGIC[4] = { 'P', 'B', 'I', 'N' };
+
+#pragma pack(push, 1)
+    struct BinaryHeader {
+        char magic[4];
+        uint32_t format;
+        uint32_t length;
+        uint64_t key;
+    };
+#pragma pack(pop)
+
+    std::string cacheDirectory = "shader_cache";
+
+    uint64_t hashPart(std::string_view text, uint64_t hash) {
+        // Разделитель, чтобы ("ab", "c") и ("a", "bc") давали разные ключи
+        const char separator = '\0';
+        return fnv1a64(&separator, 1, fnv1a64(text, hash));
+    }
+
+    std::string_view glString(GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string_view(reinterpret_cast<const char*>(value)) : std::string_view();
+    }
+}
+
+void ProgramBinaryCache::setDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+const std::string& ProgramBinaryCache::directory() {
+    return cacheDirectory;
+}
+
+uint64_t ProgramBinaryCache::key(std::string_view vertexShader, std::string_view fragmentShader, std::string_view defines) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = hashPart(vertexShader, hash);
+    hash = hashPart(fragmentShader, hash);
+    hash = hashPart(defines, hash);
+    hash = hashPart(glString(GL_VENDOR), hash);
+    hash = hashPart(glString(GL_RENDERER), hash);
+    hash = hashPart(glString(GL_VERSION), hash);
+    return hash;
+}
+
+std::string ProgramBinaryCache::path(uint64_t key) {
+    static const char digits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for (int i = 15; i >= 0; --i, key >>= 4) name[i] = digits[key & 0xF];
+    return cacheDirectory + "/" + name + ".bin";
+}
+
+bool ProgramBinaryCache::load(uint64_t key, GLuint program) {
+    if (cacheDirectory.empty()) return false;
+
+    std::ifstream input(path(key), std::ios::binary);
+    if (!input.is_open()) return false;
+
+    BinaryHeader header;
+    if (!input.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 || header.key != key) {
+        return false;
+    }
+    std::vector<char> binary(header.length);
+    if (!input.read(binary.data(), binary.size())) return false;
+
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    return success == GL_TRUE;
+}
+
+void ProgramBinaryCache::store(uint64_t key, GLuint program) {
+    if (cacheDirectory.empty()) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    std::ofstream output(path(key), std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        Logger::error_log("Could not write program binary '" + path(key) + "'");
+        return;
+    }
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.format = format;
+    header.length = static_cast<uint32_t>(length);
+    header.key = key;
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(binary.data(), length);
+}
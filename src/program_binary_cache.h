@@ -0,0 +1,27 @@
+#pragma once
+#include <glad/gl.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Дисковый кеш слинкованных программ (glGetProgramBinary / glProgramBinary).
+// Ключ - хеш исходников, набора #define и строк GL_VENDOR/GL_RENDERER/GL_VERSION,
+// так что смена драйвера или видеокарты сама по себе даёт промах.
+class ProgramBinaryCache {
+public:
+    // Пустая строка отключает кеш
+    static void setDirectory(const std::string& directory);
+
+    static const std::string& directory();
+
+    static uint64_t key(std::string_view vertexShader, std::string_view fragmentShader, std::string_view defines);
+
+    // Загружает бинарник в program. false - нет в кеше или драйвер его отверг
+    static bool load(uint64_t key, GLuint program);
+
+    // Сохраняет бинарник уже слинкованной программы
+    static void store(uint64_t key, GLuint program);
+
+private:
+    static std::string path(uint64_t key);
+};
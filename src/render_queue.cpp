@@ -0,0 +1,52 @@
+#include "render_queue.h"
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(Pass pass, uint32_t program, uint32_t texture, uint32_t mesh, uint32_t material, float depth) {
+    auto field = [](uint64_t value, uint32_t bits) { return value & ((uint64_t(1) << bits) - 1); };
+
+    const float clamped = std::min(std::max(depth, 0.0f), 1.0f);
+    const uint64_t quantizedDepth = static_cast<uint64_t>(clamped * float((1u << DEPTH_BITS) - 1));
+
+    uint64_t key = field(static_cast<uint32_t>(pass), PASS_BITS);
+    key = key << PROGRAM_BITS | field(program, PROGRAM_BITS);
+    key = key << TEXTURE_BITS | field(texture, TEXTURE_BITS);
+    key = key << MESH_BITS | field(mesh, MESH_BITS);
+    key = key << MATERIAL_BITS | field(material, MATERIAL_BITS);
+    key = key << DEPTH_BITS | quantizedDepth;
+    return key;
+}
+
+void RenderQueue::clear() {
+    mItems.clear();
+}
+
+void RenderQueue::push(uint64_t key, uint32_t index) {
+    mItems.push_back({ key, index });
+}
+
+void RenderQueue::sort() {
+    const size_t count = mItems.size();
+    if (count < 2) return;
+    mScratch.resize(count);
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        size_t histogram[256] = {};
+        for (const Item& item : mItems) ++histogram[(item.key >> shift) & 0xFF];
+
+        // Все элементы в одной корзине - проход ничего не переставит
+        if (histogram[(mItems[0].key >> shift) & 0xFF] == count) continue;
+
+        size_t offset = 0;
+        for (size_t& bucket : histogram) {
+            const size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (const Item& item : mItems) mScratch[histogram[(item.key >> shift) & 0xFF]++] = item;
+        mItems.swap(mScratch);
+    }
+}
+
+const std::vector<RenderQueue::Item>& RenderQueue::items() const {
+    return mItems;
+}
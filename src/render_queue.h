@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Очередь отрисовки: каждый видимый объект кладёт 64-битный ключ и индекс своих
+// данных, очередь сортируется поразрядно, и объекты рисуются в порядке ключей.
+// Поля ключа от старших битов к младшим - от самого дорогого переключения
+// состояния к самому дешёвому, глубина последней даёт порядок спереди назад.
+class RenderQueue {
+public:
+    enum class Pass : uint32_t {
+        Opaque = 0
+    };
+
+    static constexpr uint32_t PASS_BITS = 2;
+    static constexpr uint32_t PROGRAM_BITS = 10;
+    static constexpr uint32_t TEXTURE_BITS = 12;
+    static constexpr uint32_t MESH_BITS = 12;
+    static constexpr uint32_t MATERIAL_BITS = 12;
+    static constexpr uint32_t DEPTH_BITS = 16;
+
+    struct Item {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // depth - расстояние до камеры, нормированное в [0, 1]. Идентификаторы,
+    // не помещающиеся в своё поле, обрезаются: порядок хуже, но отрисовка верна
+    static uint64_t makeKey(Pass pass, uint32_t program, uint32_t texture, uint32_t mesh, uint32_t material, float depth);
+
+    void clear();
+
+    void push(uint64_t key, uint32_t index);
+
+    // LSD radix sort по байтам ключа; байты, одинаковые у всех элементов, пропускаются
+    void sort();
+
+    const std::vector<Item>& items() const;
+
+private:
+    std::vector<Item> mItems;
+    std::vector<Item> mScratch;
+};
@@ -2,23 +2,20 @@
 
 void Renderer::draw(const VAO& vao, const EBO& ebo) {
 
+    // Привязки остаются до следующей отрисовки: GLStateCache пропустит повторные
     vao.bind();
     ebo.bind();
     glDrawElements(GL_TRIANGLES, ebo.count(), GL_UNSIGNED_INT, 0);
-    vao.unbind();
-    ebo.unbind();
 }
 
 void Renderer::draw(const VAO& vao) {
     vao.bind();
     glDrawArrays(GL_TRIANGLES, 0, vao.count());
-    vao.unbind();
 }
 
 void Renderer::draw(VAO* vao) {
     vao->bind();
     glDrawArrays(GL_TRIANGLES, 0, vao->count());
-    vao->unbind();
 }
 
 void Renderer::draw(VAO* vao, EBO* ebo)
@@ -26,8 +23,6 @@ void Renderer::draw(VAO* vao, EBO* ebo)
     vao->bind();
     ebo->bind();
     glDrawElements(GL_TRIANGLES, ebo->count(), GL_UNSIGNED_INT, 0);
-    vao->unbind();
-    ebo->unbind();
 }
 
 void Renderer::setClearColor(float r, float g, float b, float a) {
@@ -8,16 +8,7 @@
 #include <random>
 #include <chrono>
 #include "logger.hpp"
-static std::string readFile(const std::string& path) {
-	std::ifstream input_file(path);
-	if (!input_file.is_open()) {
-		std::cerr << "Could not open the file - '"
-			<< path << "'" << std::endl;
-		exit(EXIT_FAILURE);
-	}
-	return std::string{ (std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>() };
-}
-
+#include "load_profiler.h"
 // Функция для генерации случайного числа в диапазоне [min, max)
 float randomFloat(float min, float max) {
 	static auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
@@ -37,35 +28,14 @@ ResourceManager::~ResourceManager() {
 }
 
 void ResourceManager::init() {
+	LoadProfiler::AssetScope profile("ResourceManager::init");
 
-	shaderPrograms.emplace("directionalLight", ShaderProgram(readFile("res/shaders/v_lighting.glsl"), readFile("res/shaders/f_lighting.glsl")));
-
-	//Новые модели и текстуры
-	m_textures.emplace("default", Texture2D("res/textures/default.jpg"));
-	m_meshes.emplace("cloud", Mesh("res/meshes/ball.obj"));
-	m_textures.emplace("cloud", Texture2D("res/textures/ball.jpg"));
-	m_meshes.emplace("terrain", Mesh("res/meshes/terrain.obj"));
-	m_textures.emplace("terrain", Texture2D("res/textures/terrain.jpg"));
-	m_meshes.emplace("tree", Mesh("res/meshes/tree.obj"));
-	m_textures.emplace("tree", Texture2D("res/textures/tree.jpg"));
-	m_meshes.emplace("plane", Mesh("res/meshes/airplane.obj"));
-	m_textures.emplace("plane", Texture2D("res/textures/airplane.jpg"));
-	m_meshes.emplace("box", Mesh("res/meshes/box.obj"));
-	m_textures.emplace("box", Texture2D("res/textures/box.jpg"));
-	m_meshes.emplace("lamp", Mesh("res/meshes/lamp.obj"));
-
-	try
-	{
-		//m_textures.emplace("skull", Texture2D("res/textures/skull.jpg"));
-		//m_textures.emplace("barrel", Texture2D("res/textures/barrel.png"));
-	}
-	catch (const std::exception& e)
-	{
-		Logger::error_log(e.what());
-	}
+	ShaderProgram::enableParallelCompile();
 
-	//m_meshes.emplace("skull", Mesh("res/meshes/skull.obj"));
-	//m_meshes.emplace("barrel", Mesh("res/meshes/barrel.obj"));
+	// Пакет необязателен: без него ресурсы читаются из res/ по отдельности
+	mountPack("res/resources.pak");
+	loadManifest("res/assets.manifest");
+	m_defaultTexture = findTexture("default");
 
 	VBOLayout menuVBOLayout;
 	menuVBOLayout.addLayoutElement(2, GL_FLOAT, GL_FALSE);
@@ -90,21 +60,339 @@ void ResourceManager::init() {
 
 void ResourceManager::destroy() {
 	//std::cout << "Destructor ResourceManager (" << this << ") called " << std::endl;
+	m_deletionQueue.flush();
+	m_programVariants.clear();
 	shaderPrograms.clear();
 	m_colors.clear();
 	m_vao.clear();
 	m_ebo.clear();
 	m_textures.clear();
+	m_meshes.clear();
+	// Меши уже вернули свои диапазоны, буферы пула больше не нужны
+	GeometryPool::getInstance().destroy();
+	m_programNames.clear();
+	m_textureNames.clear();
+	m_meshNames.clear();
+	m_defaultTexture = TextureHandle();
+	m_pack.unmount();
+}
+
+bool ResourceManager::mountPack(const std::string& path)
+{
+	if (!m_pack.mount(path)) return false;
+	std::cout << "Resource pack " << path << " mounted (" << m_pack.entryCount() << " files)" << std::endl;
+	return true;
+}
+
+std::string_view ResourceManager::fileView(const std::string& path, std::string& storage) const
+{
+	std::string_view packed = m_pack.find(path);
+	if (packed.data()) return packed;
+
+	LoadProfiler::Scope profile(LoadProfiler::Phase::FileRead);
+	std::ifstream input_file(path, std::ios::binary);
+	if (!input_file.is_open()) {
+		std::cerr << "Could not open the file - '"
+			<< path << "'" << std::endl;
+		return {};
+	}
+	storage.assign((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
+	return storage;
+}
+
+bool ResourceManager::loadManifest(const std::string& path)
+{
+	AssetManifest manifest;
+	std::string storage;
+	std::string_view text = fileView(path, storage);
+	bool ok = text.data() && manifest.parse(std::string(text), path);
+
+	std::vector<ProgramHandle> programs;
+	std::vector<TextureHandle> textures;
+	std::vector<MeshHandle> meshes;
+	for (const auto& desc : manifest.programs) {
+		ProgramHandle handle = addProgram(desc);
+		if (desc.preload) programs.push_back(handle);
+	}
+	for (const auto& desc : manifest.textures) {
+		TextureHandle handle = addTexture(desc);
+		if (desc.preload) textures.push_back(handle);
+	}
+	for (const auto& desc : manifest.meshes) {
+		MeshHandle handle = addMesh(desc);
+		if (desc.preload) meshes.push_back(handle);
+	}
+
+	// Все программы уходят драйверу сразу: пока грузятся текстуры и меши, он их компилирует
+	for (ProgramAsset& asset : shaderPrograms) submit(asset, ShaderProgram::BuildMode::Deferred);
+	for (auto handle : textures) prefetch(handle);
+	for (auto handle : meshes) prefetch(handle);
+	for (auto handle : programs) prefetch(handle);
+	return ok;
+}
+
+ProgramHandle ResourceManager::addProgram(const ProgramDesc& desc)
+{
+	ProgramHandle handle = shaderPrograms.emplace(ProgramAsset{ desc });
+	m_programNames[desc.name] = handle;
+	return handle;
+}
+
+TextureHandle ResourceManager::addTexture(const TextureDesc& desc)
+{
+	TextureHandle handle = m_textures.emplace(TextureAsset{ desc });
+	m_textureNames[desc.name] = handle;
+	return handle;
+}
+
+MeshHandle ResourceManager::addMesh(const MeshDesc& desc)
+{
+	MeshHandle handle = m_meshes.emplace(MeshAsset{ desc });
+	m_meshNames[desc.name] = handle;
+	return handle;
+}
+
+ShaderProgram* ResourceManager::load(ProgramAsset& asset)
+{
+	submit(asset, ShaderProgram::BuildMode::Immediate);
+	if (asset.resource && asset.resource->isPending()) {
+		asset.resource->finish();
+		asset.failed = !asset.resource->isCompiled();
+	}
+	return asset.resource ? &*asset.resource : nullptr;
+}
+
+void ResourceManager::submit(ProgramAsset& asset, ShaderProgram::BuildMode mode)
+{
+	if (asset.resource || asset.failed) return;
+
+	LoadProfiler::AssetScope profile(asset.desc.name);
+	std::string vertexStorage, fragmentStorage;
+	std::string_view vertexSource = fileView(asset.desc.vertexPath, vertexStorage);
+	std::string_view fragmentSource = fileView(asset.desc.fragmentPath, fragmentStorage);
+	if (!vertexSource.data() || !fragmentSource.data()) exit(EXIT_FAILURE);
+
+	asset.resource.emplace(vertexSource, fragmentSource, "", mode);
+	asset.resource->setProfileName(asset.desc.name);
+	if (!asset.resource->isPending()) asset.failed = !asset.resource->isCompiled();
+}
+
+Texture2D* ResourceManager::load(TextureAsset& asset)
+{
+	if (!asset.resource && !asset.failed) {
+		LoadProfiler::AssetScope profile(asset.desc.name);
+		try {
+			std::string_view packed = m_pack.find(asset.desc.path);
+			if (packed.data()) {
+				asset.resource.emplace(reinterpret_cast<const unsigned char*>(packed.data()), packed.size(), asset.desc.path, asset.desc.params);
+			}
+			else {
+				asset.resource.emplace(asset.desc.path.c_str(), asset.desc.params);
+			}
+		}
+		catch (const std::exception& e) {
+			Logger::error_log(e.what());
+			asset.failed = true;
+		}
+	}
+	return asset.resource ? &*asset.resource : nullptr;
+}
+
+Mesh* ResourceManager::load(MeshAsset& asset)
+{
+	if (!asset.resource && !asset.failed) {
+		LoadProfiler::AssetScope profile(asset.desc.name);
+		std::string_view packed = m_pack.find(asset.desc.path);
+		if (packed.data()) asset.resource.emplace(packed, asset.desc.path);
+		else asset.resource.emplace(asset.desc.path.c_str());
+	}
+	return asset.resource ? &*asset.resource : nullptr;
+}
+
+void ResourceManager::prefetch(ProgramHandle handle)
+{
+	if (ProgramAsset* asset = shaderPrograms.get(handle)) load(*asset);
+}
+
+void ResourceManager::prefetch(TextureHandle handle)
+{
+	if (TextureAsset* asset = m_textures.get(handle)) load(*asset);
+}
+
+void ResourceManager::prefetch(MeshHandle handle)
+{
+	if (MeshAsset* asset = m_meshes.get(handle)) load(*asset);
+}
+
+MeshRef ResourceManager::acquire(MeshHandle handle)
+{
+	return MeshRef(handle);
+}
+
+TextureRef ResourceManager::acquire(TextureHandle handle)
+{
+	return TextureRef(handle);
+}
+
+template<class AssetT>
+void ResourceManager::retire(AssetT& asset)
+{
+	if (!asset.resource || asset.desc.preload) return;
+	m_deletionQueue.push(std::move(*asset.resource));
+	asset.resource.reset();
+}
+
+void ResourceManager::addRef(MeshHandle handle)
+{
+	if (MeshAsset* asset = m_meshes.get(handle)) ++asset->refCount;
+}
+
+void ResourceManager::addRef(TextureHandle handle)
+{
+	if (TextureAsset* asset = m_textures.get(handle)) ++asset->refCount;
 }
 
+void ResourceManager::release(MeshHandle handle)
+{
+	MeshAsset* asset = m_meshes.get(handle);
+	if (asset && asset->refCount > 0 && --asset->refCount == 0) retire(*asset);
+}
+
+void ResourceManager::release(TextureHandle handle)
+{
+	TextureAsset* asset = m_textures.get(handle);
+	if (asset && asset->refCount > 0 && --asset->refCount == 0) retire(*asset);
+}
+
+void ResourceManager::unloadUnused()
+{
+	for (auto& asset : m_meshes) {
+		if (asset.refCount == 0) retire(asset);
+	}
+	for (auto& asset : m_textures) {
+		if (asset.refCount == 0) retire(asset);
+	}
+}
+
+void ResourceManager::endFrame()
+{
+	m_deletionQueue.endFrame();
+
+	// Без GL_KHR_parallel_shader_compile isReady() всегда true, и проверка
+	// просто откладывается сюда из момента отправки
+	for (ProgramAsset& asset : shaderPrograms) {
+		if (asset.resource && asset.resource->isPending() && asset.resource->isReady()) load(asset);
+	}
+	for (auto& entry : m_programVariants) {
+		ShaderProgram& program = entry.second;
+		if (program.isPending() && program.isReady()) program.finish();
+	}
+}
+
+ProgramHandle ResourceManager::findProgram(const std::string& progName) const
+{
+	auto it = m_programNames.find(progName);
+	if (it != m_programNames.end()) {
+		return it->second;
+	}
+	Logger::error_log("Program not found: " + progName);
+	return ProgramHandle();
+}
+
+TextureHandle ResourceManager::findTexture(const std::string& textureName) const
+{
+	auto it = m_textureNames.find(textureName);
+	if (it != m_textureNames.end()) {
+		return it->second;
+	}
+	return m_defaultTexture;
+}
 
-ShaderProgram& ResourceManager::getProgram(const std::string& progName) {
-	//return shaderPrograms[progName];
-	auto it = shaderPrograms.find(progName);
-	if (it != shaderPrograms.end()) {
+MeshHandle ResourceManager::findMesh(const std::string& meshName) const
+{
+	auto it = m_meshNames.find(meshName);
+	if (it != m_meshNames.end()) {
 		return it->second;
 	}
-	return shaderPrograms.find("default")->second;
+	Logger::error_log("Mesh not found: " + meshName);
+	return MeshHandle();
+}
+
+ShaderProgram* ResourceManager::getProgram(ProgramHandle handle)
+{
+	ProgramAsset* asset = shaderPrograms.get(handle);
+	return asset ? load(*asset) : nullptr;
+}
+
+ShaderProgram* ResourceManager::getProgram(ProgramHandle handle, const ShaderPermutation& permutation)
+{
+	return variant(handle, permutation, ShaderProgram::BuildMode::Immediate);
+}
+
+void ResourceManager::prefetch(ProgramHandle handle, const ShaderPermutation& permutation)
+{
+	if (permutation.isGeneric()) {
+		if (ProgramAsset* asset = shaderPrograms.get(handle)) submit(*asset, ShaderProgram::BuildMode::Deferred);
+		return;
+	}
+	variant(handle, permutation, ShaderProgram::BuildMode::Deferred);
+}
+
+ShaderProgram* ResourceManager::variant(ProgramHandle handle, const ShaderPermutation& permutation, ShaderProgram::BuildMode mode)
+{
+	if (permutation.isGeneric()) return getProgram(handle);
+
+	ProgramAsset* asset = shaderPrograms.get(handle);
+	if (!asset) return nullptr;
+
+	const uint64_t key = static_cast<uint64_t>(handle.index) << 32 | permutation.key();
+	auto it = m_programVariants.find(key);
+	bool built = false;
+	if (it == m_programVariants.end()) {
+		std::string profileName = asset->desc.name + "[" + std::to_string(permutation.key()) + "]";
+		LoadProfiler::AssetScope profile(profileName);
+		std::string vertexStorage, fragmentStorage;
+		std::string_view vertexSource = fileView(asset->desc.vertexPath, vertexStorage);
+		std::string_view fragmentSource = fileView(asset->desc.fragmentPath, fragmentStorage);
+		if (!vertexSource.data() || !fragmentSource.data()) return load(*asset);
+
+		// Строка define собирается только при промахе кэша - попадание обходится без выделений
+		it = m_programVariants.try_emplace(key, vertexSource, fragmentSource, permutation.defines(), mode).first;
+		it->second.setProfileName(std::move(profileName));
+		built = true;
+	}
+	if (mode == ShaderProgram::BuildMode::Deferred) return &it->second;
+
+	ShaderProgram& program = it->second;
+	if (program.isPending()) {
+		program.finish();
+		built = true;
+	}
+	if (program.isCompiled()) return &program;
+
+	if (built) Logger::error_log("Shader variant failed, using generic program: " + asset->desc.name);
+	return load(*asset);
+}
+
+TextureHandle ResourceManager::defaultTexture() const
+{
+	return m_defaultTexture;
+}
+
+Texture2D* ResourceManager::getTexture(TextureHandle handle)
+{
+	TextureAsset* asset = m_textures.get(handle);
+	Texture2D* texture = asset ? load(*asset) : nullptr;
+	if (texture || handle == m_defaultTexture) return texture;
+
+	TextureAsset* fallback = m_textures.get(m_defaultTexture);
+	return fallback ? load(*fallback) : nullptr;
+}
+
+Mesh* ResourceManager::getMesh(MeshHandle handle)
+{
+	MeshAsset* asset = m_meshes.get(handle);
+	return asset ? load(*asset) : nullptr;
 }
 
 VAO& ResourceManager::getVAO(const std::string& vaoName)
@@ -134,27 +422,57 @@ glm::vec3& ResourceManager::getColor(const std::string& colorName)
 	return m_colors.find("default")->second;
 }
 
-Texture2D& ResourceManager::getTexture(const std::string& textureName)
-{
-	auto it = m_textures.find(textureName);
-	if (it != m_textures.end()) {
-		return it->second;
-	}
-	return m_textures.find("default")->second;
+ResourceManager& ResourceManager::getInstance() {
+	static ResourceManager instance;
 
+	return instance;
 }
 
-Mesh& ResourceManager::getMesh(const std::string& meshName)
-{
-	auto it = m_meshes.find(meshName);
-	if (it != m_meshes.end()) {
-		return it->second;
+template<class T>
+ResourceRef<T>::ResourceRef(Handle<T> handle) : mHandle(handle) {
+	ResourceManager::getInstance().addRef(mHandle);
+}
+
+template<class T>
+ResourceRef<T>::ResourceRef(const ResourceRef& other) : mHandle(other.mHandle) {
+	ResourceManager::getInstance().addRef(mHandle);
+}
+
+template<class T>
+ResourceRef<T>::ResourceRef(ResourceRef&& other) noexcept : mHandle(other.mHandle) {
+	other.mHandle = Handle<T>();
+}
+
+template<class T>
+ResourceRef<T>& ResourceRef<T>::operator=(const ResourceRef& other) {
+	if (this != &other) {
+		ResourceManager::getInstance().addRef(other.mHandle);
+		reset();
+		mHandle = other.mHandle;
 	}
-	return m_meshes.find("default")->second;
+	return *this;
 }
 
-ResourceManager& ResourceManager::getInstance() {
-	static ResourceManager instance;
+template<class T>
+ResourceRef<T>& ResourceRef<T>::operator=(ResourceRef&& other) noexcept {
+	if (this != &other) {
+		reset();
+		mHandle = other.mHandle;
+		other.mHandle = Handle<T>();
+	}
+	return *this;
+}
 
-	return instance;
+template<class T>
+ResourceRef<T>::~ResourceRef() {
+	reset();
+}
+
+template<class T>
+void ResourceRef<T>::reset() {
+	if (mHandle.isValid()) ResourceManager::getInstance().release(mHandle);
+	mHandle = Handle<T>();
 }
+
+template class ResourceRef<Mesh>;
+template class ResourceRef<Texture2D>;
@@ -1,7 +1,15 @@
 #pragma once
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <optional>
+#include "slot_map.h"
+#include "asset_manifest.h"
+#include "resource_pack.h"
+#include "resource_ref.h"
+#include "deletion_queue.h"
 #include "shader_program.h"
+#include "shader_permutation.h"
 #include "buffer_objects.h"
 #include "texture.h"
 #include "mesh.h"
@@ -15,12 +23,57 @@ public:
 
     void destroy();
 
-    ShaderProgram& getProgram(const std::string& progName);
+    // Подключает пакет ресурсов: файлы из него берутся вместо файлов в res/
+    bool mountPack(const std::string& path);
+
+    // Регистрирует ресурсы из манифеста без загрузки (кроме preload=1)
+    bool loadManifest(const std::string& path);
+
+    // Имя разрешается в дескриптор один раз, дальше доступ по дескриптору за O(1)
+    ProgramHandle findProgram(const std::string& progName) const;
+    TextureHandle findTexture(const std::string& textureName) const;
+    MeshHandle findMesh(const std::string& meshName) const;
+
+    // Ресурс загружается при первом обращении. Для устаревшего дескриптора
+    // или неудачной загрузки возвращается nullptr (текстура - "default")
+    ShaderProgram* getProgram(ProgramHandle handle);
+    Texture2D* getTexture(TextureHandle handle);
+    Mesh* getMesh(MeshHandle handle);
+
+    // Вариант программы, специализированный define из permutation. Собирается при
+    // первом запросе и кэшируется; при ошибке сборки возвращается общая программа
+    ShaderProgram* getProgram(ProgramHandle handle, const ShaderPermutation& permutation);
+
+    // Текстура-заглушка: объект с ней считается нетекстурированным
+    TextureHandle defaultTexture() const;
+
+    // Явная загрузка заранее, чтобы не платить за неё в первом кадре
+    void prefetch(ProgramHandle handle);
+    void prefetch(TextureHandle handle);
+    void prefetch(MeshHandle handle);
+
+    // Отправляет вариант программы на сборку, не дожидаясь результата
+    void prefetch(ProgramHandle handle, const ShaderPermutation& permutation);
+
+    // Владеющие ссылки: ресурс без ссылок выгружается (кроме preload=1)
+    MeshRef acquire(MeshHandle handle);
+    TextureRef acquire(TextureHandle handle);
+
+    void addRef(MeshHandle handle);
+    void addRef(TextureHandle handle);
+    void release(MeshHandle handle);
+    void release(TextureHandle handle);
+
+    // Выгружает все загруженные ресурсы, на которые нет ссылок (например, при смене сцены)
+    void unloadUnused();
+
+    // Конец кадра: удаляет GPU-объекты, которые больше не могут использоваться в полёте,
+    // и завершает программы, которые драйвер успел собрать в фоне
+    void endFrame();
+
     VAO& getVAO(const std::string& vaoName);
     EBO& getEBO(const std::string& vaoName);
     glm::vec3& getColor(const std::string& colorName);
-    Texture2D& getTexture(const std::string& textureName);
-    Mesh& getMesh(const std::string& meshName);
 private:
     ResourceManager();
 
@@ -32,10 +85,47 @@ private:
 
     ResourceManager(ResourceManager&& program) = delete;
 
-    std::map<std::string, ShaderProgram> shaderPrograms;
+    template<class T, class Desc>
+    struct Asset {
+        Desc desc;
+        std::optional<T> resource;
+        uint32_t refCount = 0;
+        bool failed = false;
+    };
+    using ProgramAsset = Asset<ShaderProgram, ProgramDesc>;
+    using TextureAsset = Asset<Texture2D, TextureDesc>;
+    using MeshAsset = Asset<Mesh, MeshDesc>;
+
+    ProgramHandle addProgram(const ProgramDesc& desc);
+    TextureHandle addTexture(const TextureDesc& desc);
+    MeshHandle addMesh(const MeshDesc& desc);
+
+    // Файл из пакета без копирования, иначе - прочитанный с диска в storage.
+    // Если файла нет нигде, у результата data() == nullptr
+    std::string_view fileView(const std::string& path, std::string& storage) const;
+
+    ShaderProgram* load(ProgramAsset& asset);
+    void submit(ProgramAsset& asset, ShaderProgram::BuildMode mode);
+    ShaderProgram* variant(ProgramHandle handle, const ShaderPermutation& permutation, ShaderProgram::BuildMode mode);
+    Texture2D* load(TextureAsset& asset);
+    Mesh* load(MeshAsset& asset);
+
+    template<class AssetT>
+    void retire(AssetT& asset);
+
+    ResourcePack m_pack;
+    DeletionQueue m_deletionQueue;
+    SlotMap<ProgramAsset, ShaderProgram> shaderPrograms;
+    SlotMap<TextureAsset, Texture2D> m_textures;
+    SlotMap<MeshAsset, Mesh> m_meshes;
+    std::unordered_map<std::string, ProgramHandle> m_programNames;
+    std::unordered_map<std::string, TextureHandle> m_textureNames;
+    std::unordered_map<std::string, MeshHandle> m_meshNames;
+    TextureHandle m_defaultTexture;
+    // Ключ - индекс программы в старших 32 битах и ShaderPermutation::key() в младших
+    std::unordered_map<uint64_t, ShaderProgram> m_programVariants;
+
     std::map<std::string, VAO> m_vao;
     std::map<std::string, EBO> m_ebo;
     std::map<std::string, glm::vec3> m_colors;
-    std::map<std::string, Texture2D> m_textures;
-    std::map<std::string, Mesh> m_meshes;
 };
\ No newline at end of file
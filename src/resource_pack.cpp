@@ -0,0 +1,151 @@
+#include "resource_pack.h"
+#include "hash.h"
+#include "logger.hpp"
+
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+uint64_t packPathHash(std::string_view path) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (char c : path) {
+        const char normalized = (c == '\\') ? '/' : c;
+        hash = fnv1a64(&normalized, 1, hash);
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+static bool samePath(std::string_view stored, std::string_view path) {
+    if (stored.size() != path.size()) return false;
+    for (size_t i = 0; i < path.size(); ++i) {
+        const char c = (path[i] == '\\') ? '/' : path[i];
+        if (stored[i] != c) return false;
+    }
+    return true;
+}
+
+ResourcePack::~ResourcePack() {
+    unmount();
+}
+
+bool ResourcePack::mount(const std::string& path) {
+    unmount();
+
+#ifdef _WIN32
+    // Файл читается целиком последовательно - подсказываем это кешу
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(PackHeader))) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    mFile = file;
+    mMapping = mapping;
+    mData = static_cast<const uint8_t*>(view);
+    mSize = static_cast<uint64_t>(size.QuadPart);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(PackHeader))) {
+        close(file);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        close(file);
+        return false;
+    }
+    // Запускаем упреждающее чтение всего пакета одним последовательным проходом
+    madvise(view, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+    madvise(view, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+    mFile = file;
+    mData = static_cast<const uint8_t*>(view);
+    mSize = static_cast<uint64_t>(info.st_size);
+#endif
+
+    mHeader = reinterpret_cast<const PackHeader*>(mData);
+    const bool valid = std::memcmp(mHeader->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0
+        && mHeader->version == PACK_VERSION
+        && mHeader->fileSize == mSize
+        && mHeader->tableSize != 0 && (mHeader->tableSize & (mHeader->tableSize - 1)) == 0
+        && mHeader->tableOffset + uint64_t(mHeader->tableSize) * sizeof(PackEntry) <= mSize
+        && mHeader->namesOffset <= mSize;
+    if (!valid) {
+        Logger::error_log("Invalid resource pack '" + path + "'");
+        unmount();
+        return false;
+    }
+    mTable = reinterpret_cast<const PackEntry*>(mData + mHeader->tableOffset);
+    return true;
+}
+
+void ResourcePack::unmount() {
+#ifdef _WIN32
+    if (mData) UnmapViewOfFile(mData);
+    if (mMapping) CloseHandle(mMapping);
+    if (mFile) CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    if (mData) munmap(const_cast<uint8_t*>(mData), static_cast<size_t>(mSize));
+    if (mFile >= 0) close(mFile);
+    mFile = -1;
+#endif
+    mData = nullptr;
+    mSize = 0;
+    mHeader = nullptr;
+    mTable = nullptr;
+}
+
+bool ResourcePack::isMounted() const {
+    return mData != nullptr;
+}
+
+std::string_view ResourcePack::find(std::string_view path) const {
+    if (!mTable) return {};
+
+    const uint64_t hash = packPathHash(path);
+    const uint32_t mask = mHeader->tableSize - 1;
+    for (uint32_t probe = 0; probe <= mask; ++probe) {
+        const PackEntry& entry = mTable[(hash + probe) & mask];
+        if (entry.hash == 0) break;
+        if (entry.hash != hash) continue;
+
+        const uint64_t nameBegin = mHeader->namesOffset + entry.nameOffset;
+        if (nameBegin + entry.nameLength > mSize || entry.offset + entry.size > mSize) break;
+        const std::string_view name(reinterpret_cast<const char*>(mData + nameBegin), entry.nameLength);
+        if (samePath(name, path)) {
+            return std::string_view(reinterpret_cast<const char*>(mData + entry.offset), static_cast<size_t>(entry.size));
+        }
+    }
+    return {};
+}
+
+uint32_t ResourcePack::entryCount() const {
+    return mHeader ? mHeader->entryCount : 0;
+}
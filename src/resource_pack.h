@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Формат пакета ресурсов (little-endian):
+//   PackHeader                              - начало файла
+//   PackEntry[tableSize]                    - хеш-таблица оглавления, открытая адресация
+//   имена файлов                            - для проверки коллизий
+//   данные                                  - каждый файл выровнен на PACK_ALIGNMENT
+// Пустая ячейка таблицы имеет hash == 0.
+constexpr char PACK_MAGIC[4] = { 'R', 'P', 'A', 'K' };
+constexpr uint32_t PACK_VERSION = 1;
+constexpr uint64_t PACK_ALIGNMENT = 4096;
+
+#pragma pack(push, 1)
+struct PackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t tableSize;
+    uint64_t tableOffset;
+    uint64_t namesOffset;
+    uint64_t fileSize;
+};
+
+struct PackEntry {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+#pragma pack(pop)
+
+// Хеш пути внутри пакета. Разделители приводятся к '/', 0 зарезервирован под пустую ячейку.
+uint64_t packPathHash(std::string_view path);
+
+// Пакет, отображённый в память только для чтения. find() возвращает
+// представление прямо в отображённую память, без копирования.
+class ResourcePack {
+public:
+    ResourcePack() = default;
+
+    ~ResourcePack();
+
+    ResourcePack(const ResourcePack&) = delete;
+
+    ResourcePack& operator=(const ResourcePack&) = delete;
+
+    bool mount(const std::string& path);
+
+    void unmount();
+
+    bool isMounted() const;
+
+    // Если файла в пакете нет, у результата data() == nullptr
+    std::string_view find(std::string_view path) const;
+
+    uint32_t entryCount() const;
+
+private:
+    const uint8_t* mData = nullptr;
+    uint64_t mSize = 0;
+    const PackHeader* mHeader = nullptr;
+    const PackEntry* mTable = nullptr;
+#ifdef _WIN32
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#else
+    int mFile = -1;
+#endif
+};
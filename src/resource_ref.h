@@ -0,0 +1,35 @@
+#pragma once
+#include "slot_map.h"
+
+// Владеющая ссылка на ресурс ResourceManager. Пока существует хотя бы одна
+// ссылка, ресурс не выгружается; после освобождения последней он уходит
+// в очередь отложенного удаления и при следующем обращении загрузится заново.
+template<class T>
+class ResourceRef {
+public:
+    ResourceRef() = default;
+
+    explicit ResourceRef(Handle<T> handle);
+
+    ResourceRef(const ResourceRef& other);
+
+    ResourceRef(ResourceRef&& other) noexcept;
+
+    ResourceRef& operator=(const ResourceRef& other);
+
+    ResourceRef& operator=(ResourceRef&& other) noexcept;
+
+    ~ResourceRef();
+
+    void reset();
+
+    Handle<T> handle() const { return mHandle; }
+
+    operator Handle<T>() const { return mHandle; }
+
+private:
+    Handle<T> mHandle;
+};
+
+using MeshRef = ResourceRef<Mesh>;
+using TextureRef = ResourceRef<Texture2D>;
@@ -0,0 +1,77 @@
+#include "scene_index.h"
+#include "resource_manager.h"
+
+Aabb SceneIndex::worldBounds(const GameObject* object) {
+    const Mesh* mesh = ResourceManager::getInstance().getMesh(object->mesh);
+    if (!mesh || !mesh->bounds.isValid()) return Aabb();
+    return mesh->bounds.transformed(object->modelMatrix());
+}
+
+void SceneIndex::insert(GameObject* object) {
+    if (mProxies.count(object) != 0) return;
+
+    const Aabb bounds = worldBounds(object);
+    if (!bounds.isValid()) return;
+    mProxies[object] = { mTree.createProxy(bounds, object), bounds.center() };
+}
+
+void SceneIndex::remove(const GameObject* object) {
+    auto it = mProxies.find(object);
+    if (it == mProxies.end()) return;
+
+    mTree.destroyProxy(it->second.id);
+    mProxies.erase(it);
+}
+
+void SceneIndex::update(const GameObject* object) {
+    auto it = mProxies.find(object);
+    if (it == mProxies.end()) return;
+
+    const Aabb bounds = worldBounds(object);
+    if (!bounds.isValid()) return;
+    const glm::vec3 center = bounds.center();
+    mTree.moveProxy(it->second.id, bounds, center - it->second.lastCenter);
+    it->second.lastCenter = center;
+}
+
+void SceneIndex::query(const Frustum& frustum, std::vector<GameObject*>& out) const {
+    mTree.query(frustum, [&](int32_t proxy) {
+        out.push_back(static_cast<GameObject*>(mTree.userData(proxy)));
+        return true;
+    });
+}
+
+void SceneIndex::query(const Aabb& box, std::vector<GameObject*>& out) const {
+    mTree.query(box, [&](int32_t proxy) {
+        out.push_back(static_cast<GameObject*>(mTree.userData(proxy)));
+        return true;
+    });
+}
+
+void SceneIndex::query(const BoundingSphere& sphere, std::vector<GameObject*>& out) const {
+    mTree.query(sphere, [&](int32_t proxy) {
+        out.push_back(static_cast<GameObject*>(mTree.userData(proxy)));
+        return true;
+    });
+}
+
+GameObject* SceneIndex::raycast(const Ray& ray, float maxT, float* hitT) const {
+    GameObject* closest = nullptr;
+    float closestT = maxT;
+    mTree.raycast(ray, maxT, [&](int32_t proxy, float) {
+        // Толстый AABB шире точного - проверяем по точным границам объекта
+        GameObject* object = static_cast<GameObject*>(mTree.userData(proxy));
+        float t;
+        if (ray.intersects(worldBounds(object), closestT, t) && t < closestT) {
+            closestT = t;
+            closest = object;
+        }
+        return closestT;
+    });
+    if (closest && hitT) *hitT = closestT;
+    return closest;
+}
+
+size_t SceneIndex::size() const {
+    return mProxies.size();
+}
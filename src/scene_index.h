@@ -0,0 +1,43 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "aabb_tree.h"
+#include "game_object.h"
+
+// Пространственный индекс объектов сцены поверх AabbTree. Границы объекта -
+// AABB его меша, перенесённый матрицей модели. После перемещения объекта
+// вызывается update(): пока объект не вышел за толстый AABB, дерево не меняется.
+class SceneIndex {
+public:
+    // Загружает меш объекта, если он ещё не загружен: без него нет границ
+    void insert(GameObject* object);
+
+    void remove(const GameObject* object);
+
+    void update(const GameObject* object);
+
+    // Объекты, чьи толстые AABB задевают область (результат дописывается в out)
+    void query(const Frustum& frustum, std::vector<GameObject*>& out) const;
+
+    void query(const Aabb& box, std::vector<GameObject*>& out) const;
+
+    void query(const BoundingSphere& sphere, std::vector<GameObject*>& out) const;
+
+    // Ближайший объект, чей AABB пересекает луч в пределах maxT, или nullptr
+    GameObject* raycast(const Ray& ray, float maxT, float* hitT = nullptr) const;
+
+    size_t size() const;
+
+private:
+    struct Proxy {
+        int32_t id;
+        // Центр на момент последнего update() - из него берётся смещение
+        glm::vec3 lastCenter;
+    };
+
+    // Пустой AABB, если меш не загрузился
+    static Aabb worldBounds(const GameObject* object);
+
+    AabbTree mTree;
+    std::unordered_map<const GameObject*, Proxy> mProxies;
+};
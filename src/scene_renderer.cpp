@@ -0,0 +1,272 @@
+#include "scene_renderer.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include "resource_manager.h"
+#include "light_buffer.h"
+#include "material_registry.h"
+#include "gl_state_cache.h"
+#include "occlusion_culler.h"
+
+// Начала массивов в кольцевом буфере; смещения вершинного и косвенного буферов должны быть кратны 4
+static constexpr unsigned int FRAME_DATA_ALIGNMENT = 16;
+
+static glm::mat3 normalMatrix(const glm::mat4& rotation, const glm::vec3& scale) {
+    // При равномерном масштабе обратная транспонированная отличается от поворота лишь
+    // множителем, а нормаль всё равно нормируется во фрагментном шейдере
+    if (scale.x == scale.y && scale.y == scale.z) return glm::mat3(rotation);
+    return glm::transpose(glm::inverse(glm::mat3(rotation) * glm::mat3(glm::scale(glm::mat4(1.0f), scale))));
+}
+
+static InstanceData instanceData(const GameObject& object) {
+    const glm::mat4 rotation = object.rotationMatrix();
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), object.position);
+    model *= rotation;
+    model = glm::scale(model, glm::vec3(object.scale));
+
+    // Матрица нормалей - один раз на объект, а не inverse() в каждой вершине
+    return { model, normalMatrix(rotation, glm::vec3(object.scale)), static_cast<int32_t>(object.material) };
+}
+
+SceneRenderer::SceneRenderer(ProgramHandle lightingProgram, const LightBuffer& lights, const MaterialRegistry& materials)
+    : mLightingProgram(lightingProgram), mLights(lights), mMaterials(materials) {}
+
+ShaderPermutation SceneRenderer::lightingPermutation() const {
+    ShaderPermutation permutation;
+    permutation.setDirectionalLights(mLights.count(Light::Type::Directional));
+    return permutation;
+}
+
+ShaderPermutation SceneRenderer::objectPermutation(const GameObject* object, ShaderPermutation permutation, RenderPath path) const {
+    // Без выборки из заглушки и без нулевой эмиссии. G-буфер эмиссию не пишет -
+    // проход освещения берёт её из материала, так что вариант по ней не нужен
+    permutation.textured = object->texture.handle() != ResourceManager::getInstance().defaultTexture();
+    if (path == RenderPath::Forward) permutation.emissive = mMaterials.get(object->material).emissionColor != glm::vec3(0.0f);
+    return permutation;
+}
+
+ProgramHandle SceneRenderer::geometryProgram(RenderPath path) const {
+    return path == RenderPath::Deferred ? mGBufferProgram : mLightingProgram;
+}
+
+ShaderPermutation SceneRenderer::geometryPermutation(RenderPath path) const {
+    // Число источников важно только программе, которая их обходит
+    return path == RenderPath::Deferred ? ShaderPermutation() : lightingPermutation();
+}
+
+void SceneRenderer::prefetchPrograms(const std::vector<GameObject*>& objects) {
+    ResourceManager& resources = ResourceManager::getInstance();
+    // Оба пути, чтобы переключение не ждало сборки
+    if (mDepthProgram.isValid()) resources.prefetch(mDepthProgram);
+    std::vector<RenderPath> paths = { RenderPath::Forward };
+    if (mGBufferProgram.isValid()) {
+        paths.push_back(RenderPath::Deferred);
+        resources.prefetch(mDeferredLightingProgram, lightingPermutation());
+    }
+    for (RenderPath path : paths) {
+        const ShaderPermutation permutation = geometryPermutation(path);
+        for (const GameObject* object : objects) {
+            resources.prefetch(geometryProgram(path), objectPermutation(object, permutation, path));
+        }
+    }
+}
+
+void SceneRenderer::setDeferredPrograms(ProgramHandle geometryProgram, ProgramHandle lightingPassProgram) {
+    mGBufferProgram = geometryProgram;
+    mDeferredLightingProgram = lightingPassProgram;
+}
+
+void SceneRenderer::setRenderPath(RenderPath path) {
+    mPath = path;
+}
+
+SceneRenderer::RenderPath SceneRenderer::renderPath() const {
+    return mPath;
+}
+
+void SceneRenderer::setViewport(int width, int height) {
+    mViewportWidth = width;
+    mViewportHeight = height;
+}
+
+void SceneRenderer::setDepthPrepassProgram(ProgramHandle program) {
+    mDepthProgram = program;
+}
+
+void SceneRenderer::setDepthPrepass(bool enabled) {
+    mDepthPrepass = enabled;
+}
+
+bool SceneRenderer::depthPrepass() const {
+    return mDepthPrepass;
+}
+
+uint32_t SceneRenderer::programId(const ShaderProgram* program) {
+    auto it = mProgramIds.find(program);
+    if (it == mProgramIds.end()) {
+        it = mProgramIds.emplace(program, static_cast<uint32_t>(mProgramIds.size())).first;
+    }
+    return it->second;
+}
+
+void SceneRenderer::render(const std::vector<GameObject*>& objects, const glm::mat4& viewProjection,
+    const glm::vec3& viewPos, float farPlane) {
+    ResourceManager& resources = ResourceManager::getInstance();
+    const RenderPath path = mGBufferProgram.isValid() && mDeferredLightingProgram.isValid() && mViewportWidth > 0
+        && mViewportHeight > 0 ? mPath : RenderPath::Forward;
+    const ProgramHandle program = geometryProgram(path);
+    // Число источников по типам одинаково для всех объектов кадра
+    const ShaderPermutation lighting = geometryPermutation(path);
+
+    // Матрицы нужны и для границ, и для буфера экземпляров - считаются один раз
+    mDraws.clear();
+    mCuller.clear();
+    for (const GameObject* object : objects) {
+        Mesh* mesh = resources.getMesh(object->mesh);
+        if (!mesh || !mesh->range.isValid()) continue;
+
+        const InstanceData instance = instanceData(*object);
+        const glm::vec3 center = glm::vec3(instance.model * glm::vec4(mesh->sphere.center, 1.0f));
+        mCuller.add({ center, mesh->sphere.radius * std::abs(object->scale) });
+        mDraws.push_back({ object, mesh, nullptr, nullptr, instance });
+    }
+
+    // Сферы отсекаются пачками по четыре, уцелевшие уточняются по AABB и буферу окклюзии
+    const Frustum frustum = Frustum::fromMatrix(viewProjection);
+    mCuller.cull(frustum, mVisible);
+
+    mQueue.clear();
+    for (uint32_t index : mVisible) {
+        Draw& draw = mDraws[index];
+        const Aabb worldBox = draw.mesh->bounds.transformed(draw.instance.model);
+        if (!frustum.intersects(worldBox)) continue;
+        if (mOcclusion && !mOcclusion->isVisible(worldBox)) continue;
+
+        const GameObject* object = draw.object;
+        const ShaderPermutation permutation = objectPermutation(object, lighting, path);
+        draw.program = resources.getProgram(program, permutation);
+        if (!draw.program) continue;
+
+        draw.texture = permutation.textured ? resources.getTexture(object->texture) : nullptr;
+
+        const float depth = glm::length(object->position - viewPos) / farPlane;
+        const TextureHandle textureHandle = object->texture.handle();
+        const uint64_t key = RenderQueue::makeKey(RenderQueue::Pass::Opaque, programId(draw.program),
+            draw.texture ? textureHandle.index : 0, object->mesh.handle().index, object->material, depth);
+
+        mQueue.push(key, index);
+    }
+
+    mQueue.sort();
+
+    // Соседние элементы очереди с тем же мешем - экземпляры одной команды,
+    // соседние команды с той же программой и текстурой - один вызов
+    mMultiDraws.clear();
+    mCommands.clear();
+    mInstances.clear();
+    const Mesh* lastMesh = nullptr;
+    for (const RenderQueue::Item& item : mQueue.items()) {
+        const Draw& draw = mDraws[item.index];
+        const bool newMultiDraw = mMultiDraws.empty() || mMultiDraws.back().program != draw.program
+            || mMultiDraws.back().texture != draw.texture;
+        if (newMultiDraw) {
+            mMultiDraws.push_back({ draw.program, draw.texture, static_cast<uint32_t>(mCommands.size()), 0 });
+        }
+        if (newMultiDraw || draw.mesh != lastMesh) {
+            const GeometryPool::Range& range = draw.mesh->range;
+            mCommands.push_back({ range.indexCount, 0, range.firstIndex, static_cast<int32_t>(range.baseVertex),
+                static_cast<uint32_t>(mInstances.size()) });
+            ++mMultiDraws.back().commandCount;
+            lastMesh = draw.mesh;
+        }
+        ++mCommands.back().instanceCount;
+        mInstances.push_back(draw.instance);
+    }
+
+    ShaderProgram* depthProgram = mDepthPrepass && mDepthProgram.isValid() ? resources.getProgram(mDepthProgram) : nullptr;
+
+    mStats.objects = static_cast<uint32_t>(objects.size());
+    mStats.visible = static_cast<uint32_t>(mInstances.size());
+    mStats.commands = static_cast<uint32_t>(mCommands.size());
+    mStats.drawCalls = static_cast<uint32_t>(mMultiDraws.size());
+    mStats.depthPrepass = depthProgram != nullptr;
+    mStats.gpuMilliseconds = mTimer.milliseconds();
+    if (mInstances.empty()) return;
+
+    // Оба массива с запасом на выравнивание начала
+    const unsigned int instanceBytes = static_cast<unsigned int>(mInstances.size() * sizeof(InstanceData));
+    const unsigned int commandBytes = static_cast<unsigned int>(mCommands.size() * sizeof(DrawCommand));
+    mFrameBuffer.beginFrame(instanceBytes + commandBytes + 2 * FRAME_DATA_ALIGNMENT);
+    const unsigned int instanceOffset = mFrameBuffer.write(mInstances.data(), instanceBytes, FRAME_DATA_ALIGNMENT);
+    mCommandOffset = mFrameBuffer.write(mCommands.data(), commandBytes, FRAME_DATA_ALIGNMENT);
+
+    mTimer.begin();
+    if (path == RenderPath::Deferred) {
+        mGBuffer.resize(mViewportWidth, mViewportHeight);
+        mGBuffer.bindForWriting();
+    }
+
+    // Вся геометрия в одном VAO, буфер экземпляров и команд общий на кадр
+    const GeometryPool& pool = GeometryPool::getInstance();
+    GLStateCache::bindBuffer(GL_DRAW_INDIRECT_BUFFER, mFrameBuffer.id());
+    if (depthProgram) {
+        // У прохода одна программа и нет текстур - вся очередь уходит одним вызовом.
+        // Цвет закрыт: f_depth.glsl ничего не пишет, а в G-буфере значения были бы не определены
+        GLStateCache::bindVertexArray(pool.depthVao());
+        glBindVertexBuffer(INSTANCE_BUFFER_BINDING, mFrameBuffer.id(), instanceOffset, sizeof(InstanceData));
+        depthProgram->use();
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(static_cast<uintptr_t>(mCommandOffset)),
+            static_cast<GLsizei>(mCommands.size()), 0);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        ++mStats.drawCalls;
+
+        // Затеняется только фрагмент, оставшийся ближайшим
+        glDepthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
+
+    GLStateCache::bindVertexArray(pool.vao());
+    glBindVertexBuffer(INSTANCE_BUFFER_BINDING, mFrameBuffer.id(), instanceOffset, sizeof(InstanceData));
+    for (const MultiDraw& multiDraw : mMultiDraws) draw(multiDraw);
+
+    if (depthProgram) {
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+    }
+
+    if (path == RenderPath::Deferred) lightGBuffer();
+    mTimer.end();
+    mFrameBuffer.endFrame();
+}
+
+void SceneRenderer::lightGBuffer() {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ShaderProgram* program = ResourceManager::getInstance().getProgram(mDeferredLightingProgram, lightingPermutation());
+    if (!program) return;
+
+    program->use();
+    mGBuffer.bindTextures(0);
+    // Треугольник покрывает каждый пиксель ровно раз, глубина окна не нужна
+    glDisable(GL_DEPTH_TEST);
+    mFullscreenVao.bind();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glEnable(GL_DEPTH_TEST);
+}
+
+const SceneRenderer::Stats& SceneRenderer::stats() const {
+    return mStats;
+}
+
+void SceneRenderer::setOcclusionCuller(OcclusionCuller* culler) {
+    mOcclusion = culler;
+}
+
+void SceneRenderer::draw(const MultiDraw& multiDraw) {
+    // Порядок очереди делает соседние привязки одинаковыми - GLStateCache их пропустит
+    multiDraw.program->use();
+    if (multiDraw.texture) multiDraw.texture->bind(0);
+
+    const uintptr_t offset = mCommandOffset + multiDraw.firstCommand * sizeof(DrawCommand);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset),
+        static_cast<GLsizei>(multiDraw.commandCount), 0);
+}
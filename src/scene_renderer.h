@@ -0,0 +1,152 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include "buffer_objects.h"
+#include "dynamic_ring_buffer.h"
+#include "frustum_culler.h"
+#include "gbuffer.h"
+#include "gpu_timer.h"
+#include "game_object.h"
+#include "instance_data.h"
+#include "render_queue.h"
+#include "shader_permutation.h"
+#include "slot_map.h"
+
+class LightBuffer;
+class OcclusionCuller;
+class MaterialRegistry;
+
+// Отрисовка объектов сцены программой освещения. Каждый кадр объекты
+// собираются в RenderQueue и сортируются по ключу. Подряд идущие объекты
+// с общим мешем становятся одной командой с несколькими экземплярами
+// (матрицы и материалы - в буфере экземпляров), а все команды с общими
+// программой и текстурой уходят одним glMultiDrawElementsIndirect.
+// В отложенном режиме те же команды пишут G-буфер, а освещение считается
+// одним полноэкранным проходом - по разу на видимый пиксель.
+// Предварительный проход глубины рисует всю очередь одним вызовом по потоку
+// позиций, после чего основной проход затеняет только видимые фрагменты.
+class SceneRenderer {
+public:
+    enum class RenderPath { Forward, Deferred };
+
+    SceneRenderer(ProgramHandle lightingProgram, const LightBuffer& lights, const MaterialRegistry& materials);
+
+    // Программы отложенного пути: запись G-буфера и полноэкранное освещение
+    void setDeferredPrograms(ProgramHandle geometryProgram, ProgramHandle lightingPassProgram);
+
+    // Переключается между кадрами; Deferred без setDeferredPrograms рисует как Forward
+    void setRenderPath(RenderPath path);
+
+    RenderPath renderPath() const;
+
+    // Размер кадрового буфера окна - по нему создаётся G-буфер
+    void setViewport(int width, int height);
+
+    // Программа прохода глубины (v_depth.glsl)
+    void setDepthPrepassProgram(ProgramHandle program);
+
+    // Основной проход идёт с GL_EQUAL и без записи глубины; без программы не действует
+    void setDepthPrepass(bool enabled);
+
+    bool depthPrepass() const;
+
+    // Отправляет на сборку все варианты программы, которые понадобятся объектам
+    void prefetchPrograms(const std::vector<GameObject*>& objects);
+
+    struct Stats {
+        uint32_t objects = 0;
+        uint32_t visible = 0;
+        uint32_t commands = 0;
+        uint32_t drawCalls = 0;
+        bool depthPrepass = false;
+        // Время GPU на проходы сцены, с задержкой GpuTimer::LATENCY кадров
+        float gpuMilliseconds = 0.0f;
+    };
+
+    // Объекты вне пирамиды viewProjection не рисуются. farPlane - дальняя
+    // плоскость отсечения, по ней нормируется глубина в ключе
+    void render(const std::vector<GameObject*>& objects, const glm::mat4& viewProjection,
+        const glm::vec3& viewPos, float farPlane);
+
+    // Счётчики последнего render()
+    const Stats& stats() const;
+
+    // Объекты, закрытые окклюдерами, не рисуются. nullptr - без этой проверки.
+    // Буфер окклюзии должен быть отрисован с той же камеры до render()
+    void setOcclusionCuller(OcclusionCuller* culler);
+
+private:
+    struct Draw {
+        const GameObject* object;
+        Mesh* mesh;
+        Texture2D* texture;
+        ShaderProgram* program;
+        InstanceData instance;
+    };
+
+    ShaderPermutation lightingPermutation() const;
+
+    // Самый узкий вариант шейдера для объекта на данном пути
+    ShaderPermutation objectPermutation(const GameObject* object, ShaderPermutation permutation, RenderPath path) const;
+
+    // Программа, которой рисуются объекты, и её общий для кадра вариант
+    ProgramHandle geometryProgram(RenderPath path) const;
+
+    ShaderPermutation geometryPermutation(RenderPath path) const;
+
+    // Освещает G-буфер полноэкранным треугольником в кадровый буфер окна
+    void lightGBuffer();
+
+    // Раскладка DrawElementsIndirectCommand. baseInstance - начало группы
+    // в буфере экземпляров, от него считаются атрибуты с делителем
+    struct DrawCommand {
+        uint32_t count;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t baseVertex;
+        uint32_t baseInstance;
+    };
+
+    // Команды [firstCommand, firstCommand + commandCount) с общими программой и текстурой
+    struct MultiDraw {
+        ShaderProgram* program;
+        Texture2D* texture;
+        uint32_t firstCommand;
+        uint32_t commandCount;
+    };
+
+    // Короткий номер программы для ключа сортировки
+    uint32_t programId(const ShaderProgram* program);
+
+    void draw(const MultiDraw& multiDraw);
+
+    ProgramHandle mLightingProgram;
+    ProgramHandle mGBufferProgram;
+    ProgramHandle mDeferredLightingProgram;
+    ProgramHandle mDepthProgram;
+    bool mDepthPrepass = false;
+    GpuTimer mTimer;
+    RenderPath mPath = RenderPath::Forward;
+    GBuffer mGBuffer;
+    VAO mFullscreenVao;
+    int mViewportWidth = 0;
+    int mViewportHeight = 0;
+    const LightBuffer& mLights;
+    const MaterialRegistry& mMaterials;
+
+    RenderQueue mQueue;
+    std::vector<Draw> mDraws;
+    FrustumCuller mCuller;
+    OcclusionCuller* mOcclusion = nullptr;
+    std::vector<uint32_t> mVisible;
+    std::vector<MultiDraw> mMultiDraws;
+    std::vector<DrawCommand> mCommands;
+    std::vector<InstanceData> mInstances;
+    // Экземпляры и команды кадра - memcpy в область кольцевого буфера
+    DynamicRingBuffer mFrameBuffer;
+    unsigned int mCommandOffset = 0;
+    std::unordered_map<const ShaderProgram*, uint32_t> mProgramIds;
+    Stats mStats;
+};
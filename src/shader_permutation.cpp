@@ -0,0 +1,29 @@
+#include "shader_permutation.h"
+
+void ShaderPermutation::setDirectionalLights(int count) {
+    directionalLights = count > MAX_SPECIALIZED_LIGHTS ? DYNAMIC_LIGHTS : count;
+}
+
+bool ShaderPermutation::isGeneric() const {
+    return directionalLights == DYNAMIC_LIGHTS && textured && emissive;
+}
+
+uint64_t ShaderPermutation::key() const {
+    // Байт на число источников (0xFF - из буфера) и по биту на флаги
+    auto countBits = [](int count) -> uint64_t {
+        return count == DYNAMIC_LIGHTS ? 0xFFu : static_cast<uint64_t>(count) & 0xFFu;
+    };
+    return countBits(directionalLights)
+        | static_cast<uint64_t>(textured) << 8
+        | static_cast<uint64_t>(emissive) << 9;
+}
+
+std::string ShaderPermutation::defines() const {
+    std::string result;
+    if (directionalLights != DYNAMIC_LIGHTS) {
+        result += "#define NUM_DIRECTIONAL_LIGHTS " + std::to_string(directionalLights) + "\n";
+    }
+    if (!textured) result += "#define NO_TEXTURE\n";
+    if (!emissive) result += "#define NO_EMISSION\n";
+    return result;
+}
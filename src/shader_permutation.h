@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Набор #define, которым специализируется программа освещения (f_lighting.glsl).
+// Значения по умолчанию дают общий вариант - тот же, что собирается без define.
+struct ShaderPermutation {
+    // При большем числе источников циклы с постоянной длиной не дают выигрыша,
+    // а число вариантов растёт - тогда используется вариант с числом из буфера
+    static constexpr int MAX_SPECIALIZED_LIGHTS = 8;
+
+    static constexpr int DYNAMIC_LIGHTS = -1;
+
+    // Точечные источники и прожекторы берутся из списков кластеров, их число
+    // меняется от фрагмента к фрагменту - специализируются только направленные
+    int directionalLights = DYNAMIC_LIGHTS;
+    bool textured = true;
+    bool emissive = true;
+
+    // Задаёт число направленных источников или общий вариант, если их больше MAX_SPECIALIZED_LIGHTS
+    void setDirectionalLights(int count);
+
+    // Все поля по умолчанию: define не нужны, подходит программа без вариантов
+    bool isGeneric() const;
+
+    // Уникален для каждого набора define - ключ кэша вариантов
+    uint64_t key() const;
+
+    std::string defines() const;
+};
@@ -1,43 +1,232 @@
 #include "shader_program.h"
 
 #include <iostream>
+#include <optional>
+#include "load_profiler.h"
+#include "gl_state_cache.h"
+#include "program_binary_cache.h"
+#include "frame_data.h"
+#include "light_buffer.h"
+#include "material_registry.h"
+#include "light_clusters.h"
 #include <glm/gtc/type_ptr.hpp>
 
-ShaderProgram::ShaderProgram(const char* vertexShader, const char* fragmentShader) {
+ShaderProgram::ShaderProgram(const char* vertexShader, const char* fragmentShader) : ShaderProgram(std::string_view(vertexShader),
+    std::string_view(fragmentShader)) {
+}
+
+static std::string injectDefines(std::string_view source, const std::string& defines) {
+    // #version обязан быть первой директивой, поэтому вставляем после него
+    size_t insertAt = 0;
+    const size_t version = source.find("#version");
+    if (version != std::string_view::npos) {
+        const size_t lineEnd = source.find('\n', version);
+        insertAt = (lineEnd == std::string_view::npos) ? source.size() : lineEnd + 1;
+    }
+    std::string result;
+    result.reserve(source.size() + defines.size() + 1);
+    result.append(source.substr(0, insertAt));
+    if (insertAt != 0 && result.back() != '\n') result += '\n';
+    result.append(defines);
+    if (!defines.empty() && defines.back() != '\n') result += '\n';
+    result.append(source.substr(insertAt));
+    return result;
+}
+
+ShaderProgram::ShaderProgram(std::string_view vertexShader, std::string_view fragmentShader, const std::string& defines,
+    BuildMode mode) {
     //std::cout << "Constructor ShaderProgram (" << this << ") called " << std::endl;
-    GLuint hVertexSh;
-    if (!createShader(vertexShader, GL_VERTEX_SHADER, hVertexSh)) return;
+    mLocations.fill(-1);
+    mCacheKey = ProgramBinaryCache::key(vertexShader, fragmentShader, defines);
+    {
+        LoadProfiler::Scope profile(LoadProfiler::Phase::CacheLoad);
+        hProgram = glCreateProgram();
+        if (ProgramBinaryCache::load(mCacheKey, hProgram)) {
+            compiled = true;
+            reflectUniforms();
+            bindBlocks();
+            return;
+        }
+        // Бинарника нет или драйвер его отверг - собираем из исходников
+        glDeleteProgram(hProgram);
+        hProgram = 0;
+    }
+
+    if (defines.empty()) submit(vertexShader, fragmentShader);
+    else submit(injectDefines(vertexShader, defines), injectDefines(fragmentShader, defines));
+
+    if (mode == BuildMode::Immediate) finish();
+}
+
+void ShaderProgram::enableParallelCompile() {
+#ifdef GL_KHR_parallel_shader_compile
+    // 0xFFFFFFFF - столько потоков, сколько сочтёт нужным драйвер
+    if (GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+#endif
+}
+
+void ShaderProgram::reflectUniforms() {
+    mUniforms.clear();
+    mLocations.fill(-1);
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(hProgram, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(hProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    auto addUniform = [this](const std::string& uniformName, const UniformInfo& info) {
+        const uint64_t hash = fnv1a64(uniformName);
+        mUniforms[hash] = info;
+        const int index = shader_uniforms::indexOf(hash);
+        if (index >= 0) mLocations[index] = info.location;
+    };
+
+    std::string name(maxLength > 0 ? maxLength : 1, '\0');
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(hProgram, i, maxLength, &length, &size, &type, name.data());
+        std::string uniformName(name.data(), length);
+
+        // У членов uniform-блоков нет расположения
+        const GLint uniformLocation = glGetUniformLocation(hProgram, uniformName.c_str());
+        if (uniformLocation < 0) continue;
+
+        addUniform(uniformName, { uniformLocation, type, size });
+
+        // Массив приходит как "name[0]" - регистрируем и "name", и каждый элемент
+        const size_t bracket = uniformName.rfind("[0]");
+        if (bracket != std::string::npos && bracket + 3 == uniformName.size()) {
+            const std::string base = uniformName.substr(0, bracket);
+            addUniform(base, { uniformLocation, type, size });
+            for (GLint element = 1; element < size; ++element) {
+                const std::string elementName = base + "[" + std::to_string(element) + "]";
+                addUniform(elementName, { glGetUniformLocation(hProgram, elementName.c_str()), type, 1 });
+            }
+        }
+    }
+}
+
+void ShaderProgram::bindBlocks() {
+    const GLuint frameData = glGetUniformBlockIndex(hProgram, "FrameData");
+    if (frameData != GL_INVALID_INDEX) glUniformBlockBinding(hProgram, frameData, FRAME_DATA_BINDING);
+
+    const GLuint lightBuffer = glGetProgramResourceIndex(hProgram, GL_SHADER_STORAGE_BLOCK, "LightBuffer");
+    if (lightBuffer != GL_INVALID_INDEX) glShaderStorageBlockBinding(hProgram, lightBuffer, LIGHT_BUFFER_BINDING);
+
+    const GLuint materialBuffer = glGetProgramResourceIndex(hProgram, GL_SHADER_STORAGE_BLOCK, "MaterialBuffer");
+    if (materialBuffer != GL_INVALID_INDEX) glShaderStorageBlockBinding(hProgram, materialBuffer, MATERIAL_BUFFER_BINDING);
+
+    const GLuint lightClusters = glGetProgramResourceIndex(hProgram, GL_SHADER_STORAGE_BLOCK, "LightClusterBuffer");
+    if (lightClusters != GL_INVALID_INDEX) glShaderStorageBlockBinding(hProgram, lightClusters, LIGHT_CLUSTER_BINDING);
+}
+
+// Сэмплеры и образы задаются номером блока через glUniform1i, как и bool; так же их видит tools/uniformgen
+static bool isIntLike(GLenum type) {
+    return type == GL_BOOL
+        || (type >= GL_SAMPLER_1D && type <= GL_SAMPLER_2D_RECT_SHADOW)
+        || (type >= GL_SAMPLER_1D_ARRAY && type <= GL_SAMPLER_CUBE_SHADOW)
+        || (type >= GL_INT_SAMPLER_1D && type <= GL_UNSIGNED_INT_SAMPLER_BUFFER)
+        || (type >= GL_SAMPLER_CUBE_MAP_ARRAY && type <= GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY)
+        || (type >= GL_SAMPLER_2D_MULTISAMPLE && type <= GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY)
+        || (type >= GL_IMAGE_1D && type <= GL_UNSIGNED_INT_IMAGE_2D_MULTISAMPLE_ARRAY);
+}
+
+GLint ShaderProgram::findUniform(std::string_view uniformName, GLenum expectedType) const {
+    auto it = mUniforms.find(fnv1a64(uniformName));
+    if (it == mUniforms.end()) return -1;
+
+    const GLenum type = it->second.type;
+    const bool intLike = expectedType == GL_INT && isIntLike(type);
+    if (type != expectedType && !intLike) {
+        std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << uniformName << std::endl;
+        return -1;
+    }
+    return it->second.location;
+}
 
-    GLuint hFragmentSh;
-    if (!createShader(fragmentShader, GL_FRAGMENT_SHADER, hFragmentSh)) {
-        glDeleteShader(hVertexSh);
-        return;
+const std::unordered_map<uint64_t, UniformInfo>& ShaderProgram::uniforms() const {
+    return mUniforms;
+}
+
+void ShaderProgram::submit(std::string_view vertexShader, std::string_view fragmentShader) {
+    {
+        LoadProfiler::Scope profile(LoadProfiler::Phase::Compile);
+        mPendingShaders[0] = compileShader(vertexShader, GL_VERTEX_SHADER);
+        mPendingShaders[1] = compileShader(fragmentShader, GL_FRAGMENT_SHADER);
     }
+    LoadProfiler::Scope profile(LoadProfiler::Phase::Link);
     hProgram = glCreateProgram();
-    glAttachShader(hProgram, hVertexSh);
-    glAttachShader(hProgram, hFragmentSh);
+    glProgramParameteri(hProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(hProgram, mPendingShaders[0]);
+    glAttachShader(hProgram, mPendingShaders[1]);
     glLinkProgram(hProgram);
-    // Check for linking errors
+    mPending = true;
+}
+
+bool ShaderProgram::isPending() const {
+    return mPending;
+}
+
+bool ShaderProgram::isReady() const {
+    if (!mPending) return true;
+#ifdef GL_KHR_parallel_shader_compile
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(hProgram, GL_COMPLETION_STATUS_KHR, &done);
+        return done == GL_TRUE;
+    }
+#endif
+    // Без расширения узнать готовность нельзя - запрос статуса просто отложен до finish()
+    return true;
+}
+
+void ShaderProgram::finish() {
+    if (!mPending) return;
+    mPending = false;
+
+    std::optional<LoadProfiler::AssetScope> asset;
+    if (!mProfileName.empty()) asset.emplace(mProfileName);
+    LoadProfiler::Scope profile(LoadProfiler::Phase::Link);
+    // Журнал компиляции нужен, только если линковка не удалась
     GLint success;
     glGetProgramiv(hProgram, GL_LINK_STATUS, &success);
     if (!success) {
-        GLchar infoLog[512];
-        glGetProgramInfoLog(hProgram, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        const bool shadersCompiled = checkShader(mPendingShaders[0], GL_VERTEX_SHADER)
+            & checkShader(mPendingShaders[1], GL_FRAGMENT_SHADER);
+        if (shadersCompiled) {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(hProgram, 512, nullptr, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
     }
     else {
         compiled = true;
     }
-    glDeleteShader(hVertexSh);
-    glDeleteShader(hFragmentSh);
+    glDeleteShader(mPendingShaders[0]);
+    glDeleteShader(mPendingShaders[1]);
+    mPendingShaders[0] = mPendingShaders[1] = 0;
 
+    if (compiled) {
+        ProgramBinaryCache::store(mCacheKey, hProgram);
+        reflectUniforms();
+        bindBlocks();
+    }
+}
 
+void ShaderProgram::setProfileName(std::string name) {
+    mProfileName = std::move(name);
 }
 
-bool ShaderProgram::createShader(const char* source, const GLenum type, GLuint& hShader) {
-    hShader = glCreateShader(type);
-    glShaderSource(hShader, 1, &source, nullptr);
+GLuint ShaderProgram::compileShader(std::string_view source, const GLenum type) {
+    GLuint hShader = glCreateShader(type);
+    const GLchar* text = source.data();
+    const GLint length = static_cast<GLint>(source.size());
+    glShaderSource(hShader, 1, &text, &length);
     glCompileShader(hShader);
+    return hShader;
+}
+
+bool ShaderProgram::checkShader(GLuint hShader, const GLenum type) {
     // Check for compile time errors
     GLint success;
     glGetShaderiv(hShader, GL_COMPILE_STATUS, &success);
@@ -57,33 +246,50 @@ bool ShaderProgram::isCompiled() const {
 }
 
 void ShaderProgram::use() {
-    glUseProgram(hProgram);
+    if (mPending) finish();
+    GLStateCache::useProgram(hProgram);
 }
 
 
 void ShaderProgram::unbind() {
-    glUseProgram(0);
+    GLStateCache::useProgram(0);
 }
 
 ShaderProgram::~ShaderProgram() {
     // std::cout << "Destructor ShaderProgram (" << this << ") called " << std::endl;
+    GLStateCache::forgetProgram(hProgram);
     glDeleteProgram(hProgram);
     hProgram = 0;
+    // glDeleteShader(0) ничего не делает
+    glDeleteShader(mPendingShaders[0]);
+    glDeleteShader(mPendingShaders[1]);
 }
 
-ShaderProgram::ShaderProgram(const std::string& vertexShader, const std::string& fragmentShader) : ShaderProgram(vertexShader.c_str(),
-    fragmentShader.c_str()) {
+ShaderProgram::ShaderProgram(const std::string& vertexShader, const std::string& fragmentShader) : ShaderProgram(std::string_view(vertexShader),
+    std::string_view(fragmentShader)) {
 }
 
 ShaderProgram& ShaderProgram::operator=(ShaderProgram&& program) noexcept {
     // std::cout << "Assignment-Move ShaderProgram (" << this << ") called " << std::endl;
     if (this != &program) {
+        GLStateCache::forgetProgram(hProgram);
         glDeleteProgram(hProgram);
+        glDeleteShader(mPendingShaders[0]);
+        glDeleteShader(mPendingShaders[1]);
         hProgram = program.hProgram;
         compiled = program.compiled;
+        mUniforms = std::move(program.mUniforms);
+        mLocations = program.mLocations;
+        mPending = program.mPending;
+        mPendingShaders[0] = program.mPendingShaders[0];
+        mPendingShaders[1] = program.mPendingShaders[1];
+        mCacheKey = program.mCacheKey;
+        mProfileName = std::move(program.mProfileName);
 
         program.hProgram = 0;
         program.compiled = false;
+        program.mPending = false;
+        program.mPendingShaders[0] = program.mPendingShaders[1] = 0;
     }
     return *this;
 }
@@ -92,10 +298,18 @@ ShaderProgram::ShaderProgram(ShaderProgram&& program) noexcept {
     // std::cout << "Constructor-Move ShaderProgram (" << this << ") called " << std::endl;
     hProgram = program.hProgram;
     compiled = program.compiled;
+    mUniforms = std::move(program.mUniforms);
+    mLocations = program.mLocations;
+    mPending = program.mPending;
+    mPendingShaders[0] = program.mPendingShaders[0];
+    mPendingShaders[1] = program.mPendingShaders[1];
+    mCacheKey = program.mCacheKey;
+    mProfileName = std::move(program.mProfileName);
 
     program.hProgram = 0;
     program.compiled = false;
-
+    program.mPending = false;
+    program.mPendingShaders[0] = program.mPendingShaders[1] = 0;
 }
 
 
@@ -103,24 +317,52 @@ GLuint& ShaderProgram::getUintProgram() {
     return hProgram;
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::mat4& matrixValue) {
-    glUniformMatrix4fv(glGetUniformLocation(hProgram, uniformName.c_str()), 1, GL_FALSE, glm::value_ptr(matrixValue));
+void ShaderProgram::setUniform(Uniform<glm::mat4> uniform, const glm::mat4& matrixValue) {
+    upload(uniform.location, matrixValue);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::mat3> uniform, const glm::mat3& matrixValue) {
+    upload(uniform.location, matrixValue);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::vec4> uniform, const glm::vec4& vec4Value) {
+    upload(uniform.location, vec4Value);
+}
+
+void ShaderProgram::setUniform(Uniform<glm::vec3> uniform, const glm::vec3& vec3Value) {
+    upload(uniform.location, vec3Value);
+}
+
+void ShaderProgram::setUniform(Uniform<float> uniform, float value) {
+    upload(uniform.location, value);
+}
+
+void ShaderProgram::setUniform(Uniform<int> uniform, int value) {
+    upload(uniform.location, value);
+}
+
+void ShaderProgram::upload(GLint location, const glm::mat4& matrixValue) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(matrixValue));
+}
+
+void ShaderProgram::upload(GLint location, const glm::mat3& matrixValue) {
+    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(matrixValue));
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::vec4& vec4Value) {
-    glUniform4f(glGetUniformLocation(hProgram, uniformName.c_str()), vec4Value.x, vec4Value.y, vec4Value.z, vec4Value.w);
+void ShaderProgram::upload(GLint location, const glm::vec4& vec4Value) {
+    glUniform4f(location, vec4Value.x, vec4Value.y, vec4Value.z, vec4Value.w);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, const glm::vec3& vec3Value) {
-    glUniform3f(glGetUniformLocation(hProgram, uniformName.c_str()), vec3Value.x, vec3Value.y, vec3Value.z);
+void ShaderProgram::upload(GLint location, const glm::vec3& vec3Value) {
+    glUniform3f(location, vec3Value.x, vec3Value.y, vec3Value.z);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, float value) {
-    glUniform1f(glGetUniformLocation(hProgram, uniformName.c_str()), value);
+void ShaderProgram::upload(GLint location, float value) {
+    glUniform1f(location, value);
 }
 
-void ShaderProgram::setUniform(const std::string& uniformName, int value) {
-    glUniform1i(glGetUniformLocation(hProgram, uniformName.c_str()), value);
+void ShaderProgram::upload(GLint location, int value) {
+    glUniform1i(location, value);
 }
 
 
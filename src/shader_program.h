@@ -2,7 +2,13 @@
 #include <glad/gl.h>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <array>
 #include <glm/mat4x4.hpp>
+#include <glm/mat3x3.hpp>
+#include "hash.h"
+#include "shader_uniforms.h"
 
 class GLType {
 
@@ -16,6 +22,38 @@ public:
 };
 
 
+template<class T> struct UniformTraits;
+template<> struct UniformTraits<glm::mat4> { static constexpr GLenum type = GL_FLOAT_MAT4; };
+template<> struct UniformTraits<glm::mat3> { static constexpr GLenum type = GL_FLOAT_MAT3; };
+template<> struct UniformTraits<glm::vec4> { static constexpr GLenum type = GL_FLOAT_VEC4; };
+template<> struct UniformTraits<glm::vec3> { static constexpr GLenum type = GL_FLOAT_VEC3; };
+template<> struct UniformTraits<float> { static constexpr GLenum type = GL_FLOAT; };
+template<> struct UniformTraits<int> { static constexpr GLenum type = GL_INT; };
+
+// Заранее найденное расположение uniform-переменной. Получается один раз
+// через ShaderProgram::uniform<T>(), дальше setUniform не делает поисков по имени.
+template<class T>
+struct Uniform {
+    GLint location = -1;
+
+    bool isValid() const { return location >= 0; }
+};
+
+// Идентификатор uniform-переменной, известный при компиляции: UniformId<"texture1"_hash>.
+// Имя проверяется по сгенерированному из шейдеров списку shader_uniforms,
+// поэтому опечатка - ошибка компиляции, а поиск - одно обращение по индексу.
+template<uint64_t Hash>
+struct UniformId {
+    static constexpr int index = shader_uniforms::indexOf(Hash);
+    static_assert(index >= 0, "Uniform is not declared in any shader in res/shaders");
+};
+
+struct UniformInfo {
+    GLint location;
+    GLenum type;
+    GLint size;
+};
+
 class ShaderProgram {
 
 
@@ -24,23 +62,71 @@ public:
 
     ShaderProgram(const std::string& vertexShader, const std::string& fragmentShader);
 
+    // Immediate - сборка и проверка результата в конструкторе. Deferred - конструктор
+    // только отдаёт исходники драйверу, результат проверяется в finish(), так что
+    // драйвер может собирать много программ параллельно
+    enum class BuildMode { Immediate, Deferred };
+
+    // Исходники не обязаны оканчиваться нулём (например, представления в пакет ресурсов).
+    // defines вставляются в оба шейдера сразу после строки #version
+    ShaderProgram(std::string_view vertexShader, std::string_view fragmentShader, const std::string& defines = "",
+        BuildMode mode = BuildMode::Immediate);
+
+    // Включает GL_KHR_parallel_shader_compile, если драйвер его поддерживает
+    static void enableParallelCompile();
+
+    // Для отложенной сборки, результат которой ещё не проверен, - false
     bool isCompiled() const;
 
+    // Сборка отправлена, но finish() ещё не вызывался
+    bool isPending() const;
+
+    // Можно ли вызвать finish() без ожидания. С GL_KHR_parallel_shader_compile
+    // опрашивает GL_COMPLETION_STATUS_KHR, без него - всегда true
+    bool isReady() const;
+
+    // Проверяет результат отложенной сборки, при необходимости дожидаясь драйвера.
+    // use() вызывает его сам, если программа ещё не готова
+    void finish();
+
+    // Имя, под которым finish() записывает линковку в LoadProfiler: отложенная
+    // сборка завершается вне области ресурса (endFrame, use())
+    void setProfileName(std::string name);
+
     void use();
 
     void unbind();
 
     GLuint& getUintProgram();
 
-    void setUniform(const std::string& uniformName, const glm::mat4& matrixValue);
+    template<uint64_t Hash, class T>
+    void setUniform(UniformId<Hash>, const T& value) {
+        constexpr uint32_t declaredType = shader_uniforms::types[UniformId<Hash>::index];
+        static_assert(declaredType == 0 || declaredType == UniformTraits<T>::type,
+            "Value type does not match the uniform type declared in the shader");
+        upload(mLocations[UniformId<Hash>::index], value);
+    }
+
+    // Для имён, собираемых во время работы (например, элементов массивов)
+    template<class T>
+    Uniform<T> uniform(std::string_view uniformName) const {
+        return { findUniform(uniformName, UniformTraits<T>::type) };
+    }
+
+    void setUniform(Uniform<glm::mat4> uniform, const glm::mat4& matrixValue);
 
-    void setUniform(const std::string& uniformName, int value);
+    void setUniform(Uniform<glm::mat3> uniform, const glm::mat3& matrixValue);
 
-    void setUniform(const std::string& uniformName, float value);
+    void setUniform(Uniform<int> uniform, int value);
 
-    void setUniform(const std::string& uniformName, const glm::vec4& vec4Value);
+    void setUniform(Uniform<float> uniform, float value);
 
-    void setUniform(const std::string& uniformName, const glm::vec3& vec3Value);
+    void setUniform(Uniform<glm::vec4> uniform, const glm::vec4& vec4Value);
+
+    void setUniform(Uniform<glm::vec3> uniform, const glm::vec3& vec3Value);
+
+    // Все активные uniform-переменные программы по хешу имени, собранные после линковки
+    const std::unordered_map<uint64_t, UniformInfo>& uniforms() const;
 
     ~ShaderProgram();
 
@@ -54,11 +140,46 @@ public:
 
 
 private:
-    bool createShader(const char* source, const GLenum type, GLuint& hShader);
+    // Компиляция и линковка без запросов статуса - они заставили бы драйвер ждать
+    void submit(std::string_view vertexShader, std::string_view fragmentShader);
+
+    GLuint compileShader(std::string_view source, const GLenum type);
+
+    bool checkShader(GLuint hShader, const GLenum type);
+
+    void reflectUniforms();
+
+    // Назначает точки привязки общим блокам (FrameData, LightBuffer, MaterialBuffer), если программа их использует
+    void bindBlocks();
+
+    GLint findUniform(std::string_view uniformName, GLenum expectedType) const;
+
+    void upload(GLint location, const glm::mat4& matrixValue);
+
+    void upload(GLint location, const glm::mat3& matrixValue);
+
+    void upload(GLint location, int value);
+
+    void upload(GLint location, float value);
+
+    void upload(GLint location, const glm::vec4& vec4Value);
+
+    void upload(GLint location, const glm::vec3& vec3Value);
+
+    std::unordered_map<uint64_t, UniformInfo> mUniforms;
+
+    // Расположения по индексам shader_uniforms (-1, если в этой программе переменной нет)
+    std::array<GLint, shader_uniforms::count> mLocations;
 
     bool compiled = false;
 
     GLuint hProgram = 0;
 
+    // Шейдеры и ключ кеша бинарников, пока сборка не завершена finish()
+    bool mPending = false;
+    GLuint mPendingShaders[2] = { 0, 0 };
+    uint64_t mCacheKey = 0;
+    std::string mProfileName;
+
 
 };
\ No newline at end of file
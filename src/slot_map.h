@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Типизированный дескриптор ресурса: индекс слота + поколение.
+// Поколение увеличивается при удалении, поэтому устаревший дескриптор
+// не совпадёт с новым ресурсом, занявшим тот же слот.
+template<class T>
+struct Handle {
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isValid() const { return index != INVALID_INDEX; }
+
+    bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+
+    bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+class Mesh;
+class Texture2D;
+class ShaderProgram;
+
+using MeshHandle = Handle<Mesh>;
+using TextureHandle = Handle<Texture2D>;
+using ProgramHandle = Handle<ShaderProgram>;
+
+// Хранилище со стабильными дескрипторами. Значения лежат в непрерывном
+// массиве (удаление - swap-and-pop), слоты переводят дескриптор в индекс
+// этого массива за O(1). Tag задаёт тип дескриптора, если хранятся
+// не сами ресурсы, а записи о них.
+template<class T, class Tag = T>
+class SlotMap {
+public:
+    using HandleType = Handle<Tag>;
+
+    template<class... Args>
+    HandleType emplace(Args&&... args) {
+        uint32_t slotIndex;
+        if (mFreeHead != HandleType::INVALID_INDEX) {
+            slotIndex = mFreeHead;
+            mFreeHead = mSlots[slotIndex].denseIndex;
+        }
+        else {
+            slotIndex = static_cast<uint32_t>(mSlots.size());
+            mSlots.push_back({ 0, 0 });
+        }
+        mValues.emplace_back(std::forward<Args>(args)...);
+        mDenseToSlot.push_back(slotIndex);
+        mSlots[slotIndex].denseIndex = static_cast<uint32_t>(mValues.size() - 1);
+        return { slotIndex, mSlots[slotIndex].generation };
+    }
+
+    bool erase(HandleType handle) {
+        if (!contains(handle)) return false;
+
+        Slot& slot = mSlots[handle.index];
+        const uint32_t dense = slot.denseIndex;
+        const uint32_t last = static_cast<uint32_t>(mValues.size() - 1);
+        {
+            // Удаляемое значение разрушается здесь, а не при перемещении
+            T removed(std::move(mValues[dense]));
+            if (dense != last) {
+                mValues[dense] = std::move(mValues[last]);
+                mDenseToSlot[dense] = mDenseToSlot[last];
+                mSlots[mDenseToSlot[dense]].denseIndex = dense;
+            }
+            mValues.pop_back();
+            mDenseToSlot.pop_back();
+        }
+
+        ++slot.generation;
+        slot.denseIndex = mFreeHead;
+        mFreeHead = handle.index;
+        return true;
+    }
+
+    bool contains(HandleType handle) const {
+        return handle.index < mSlots.size() && mSlots[handle.index].generation == handle.generation;
+    }
+
+    T* get(HandleType handle) {
+        return contains(handle) ? &mValues[mSlots[handle.index].denseIndex] : nullptr;
+    }
+
+    const T* get(HandleType handle) const {
+        return contains(handle) ? &mValues[mSlots[handle.index].denseIndex] : nullptr;
+    }
+
+    void clear() {
+        for (uint32_t i = 0; i < mDenseToSlot.size(); ++i) {
+            Slot& slot = mSlots[mDenseToSlot[i]];
+            ++slot.generation;
+            slot.denseIndex = mFreeHead;
+            mFreeHead = mDenseToSlot[i];
+        }
+        mValues.clear();
+        mDenseToSlot.clear();
+    }
+
+    size_t size() const { return mValues.size(); }
+
+    typename std::vector<T>::iterator begin() { return mValues.begin(); }
+    typename std::vector<T>::iterator end() { return mValues.end(); }
+
+private:
+    struct Slot {
+        // Для занятого слота - индекс в mValues, для свободного - следующий свободный слот
+        uint32_t denseIndex;
+        uint32_t generation;
+    };
+
+    std::vector<T> mValues;
+    std::vector<uint32_t> mDenseToSlot;
+    std::vector<Slot> mSlots;
+    uint32_t mFreeHead = HandleType::INVALID_INDEX;
+};
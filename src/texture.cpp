@@ -1,14 +1,30 @@
 #include <texture.h>
 #include <stdexcept>
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include "load_profiler.h"
+#include "gl_state_cache.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 //#define STBI_ONLY_PNG
 #include <stb_image.h>
 
-Texture2D::Texture2D(const char* path) {
-	stbi_set_flip_vertically_on_load(true);
-	unsigned char* image = stbi_load(path, &mWidth, &mHeight, &channel, 0);
+Texture2D::Texture2D(const char* path, const TextureParams& params) {
+	// Чтение и декодирование разделены, чтобы профилировщик видел обе фазы
+	std::vector<unsigned char> file;
+	{
+		LoadProfiler::Scope profile(LoadProfiler::Phase::FileRead);
+		std::ifstream input(path, std::ios::binary);
+		if (input.is_open()) file.assign((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	}
+
+	unsigned char* image = nullptr;
+	if (!file.empty()) {
+		LoadProfiler::Scope profile(LoadProfiler::Phase::Decode);
+		stbi_set_flip_vertically_on_load(params.flipVertically);
+		image = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &mWidth, &mHeight, &channel, 0);
+	}
 
 	if (!image) {
 		std::string error = "Не удалось загрузить изображение " + std::string(path);
@@ -16,14 +32,37 @@ Texture2D::Texture2D(const char* path) {
 		throw std::exception(error.c_str());
 	}
 
+	upload(image, params);
+	//  std::cout << "Texture BASE (" << this << ") " << path << " created" << std::endl;
+}
+
+Texture2D::Texture2D(const unsigned char* data, size_t size, const std::string& name, const TextureParams& params) {
+	unsigned char* image;
+	{
+		LoadProfiler::Scope profile(LoadProfiler::Phase::Decode);
+		stbi_set_flip_vertically_on_load(params.flipVertically);
+		image = stbi_load_from_memory(data, static_cast<int>(size), &mWidth, &mHeight, &channel, 0);
+	}
+
+	if (!image) {
+		std::string error = "Не удалось загрузить изображение " + name;
+
+		throw std::exception(error.c_str());
+	}
+
+	upload(image, params);
+}
+
+void Texture2D::upload(unsigned char* image, const TextureParams& params) {
+	LoadProfiler::Scope profile(LoadProfiler::Phase::Upload);
 	glGenTextures(1, &textureID);
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	GLStateCache::bindTexture(0, GL_TEXTURE_2D, textureID);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);    // Set texture wrapping to GL_REPEAT
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
 	// Set texture filtering
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, params.minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, params.magFilter);
 
 	switch (channel) {
 	case 4:
@@ -38,14 +77,13 @@ Texture2D::Texture2D(const char* path) {
 	}
 
 	glTexImage2D(GL_TEXTURE_2D, 0, format, mWidth, mHeight, 0, format, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
+	if (params.mipmaps) glGenerateMipmap(GL_TEXTURE_2D);
 	stbi_image_free(image);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	//  std::cout << "Texture BASE (" << this << ") " << path << " created" << std::endl;
 }
 
 Texture2D::~Texture2D() {
 	// std::cout << "Texture BASE (" << this << ")" << " deleted" << std::endl;
+	GLStateCache::forgetTexture(textureID);
 	glDeleteTextures(1, &textureID);
 	textureID = 0;
 }
@@ -53,7 +91,8 @@ Texture2D::~Texture2D() {
 Texture2D& Texture2D::operator=(Texture2D&& texture) noexcept {
 	// std::cout << "Assignment-Move Texture2D (" << this << ") called " << std::endl;
 	if (this != &texture) {
-		glDeleteProgram(textureID);
+		GLStateCache::forgetTexture(textureID);
+		glDeleteTextures(1, &textureID);
 		textureID = texture.textureID;
 		format = texture.format;
 		mWidth = texture.mWidth;
@@ -77,13 +116,13 @@ Texture2D::Texture2D(Texture2D&& texture) noexcept {
 	texture.textureID = 0;
 }
 
-void Texture2D::bind() {
-	if (textureID != 0) glBindTexture(GL_TEXTURE_2D, textureID);
+void Texture2D::bind(GLuint unit) {
+	if (textureID != 0) GLStateCache::bindTexture(unit, GL_TEXTURE_2D, textureID);
 	else std::cerr << " Texture not init " << std::endl;
 }
 
-void Texture2D::unbind() {
-	glBindTexture(GL_TEXTURE_2D, 0);
+void Texture2D::unbind(GLuint unit) {
+	GLStateCache::bindTexture(unit, GL_TEXTURE_2D, 0);
 }
 
 
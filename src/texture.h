@@ -4,10 +4,21 @@
 
 #include <sub_texture.h>
 
+struct TextureParams {
+    GLint wrap = GL_CLAMP_TO_EDGE;
+    GLint minFilter = GL_LINEAR;
+    GLint magFilter = GL_LINEAR;
+    bool mipmaps = true;
+    bool flipVertically = true;
+};
+
 class Texture2D {
 public:
 
-    Texture2D(const char* path);
+    Texture2D(const char* path, const TextureParams& params = TextureParams());
+
+    // Декодирование из памяти (например, из отображённого пакета ресурсов)
+    Texture2D(const unsigned char* data, size_t size, const std::string& name, const TextureParams& params = TextureParams());
 
     ~Texture2D();
 
@@ -21,9 +32,9 @@ public:
 
     Texture2D(Texture2D&& texture2D) noexcept;
 
-    void bind();
+    void bind(GLuint unit = 0);
 
-    void unbind();
+    void unbind(GLuint unit = 0);
 
     int width();
 
@@ -31,6 +42,9 @@ public:
 
     virtual const SubTexture& getSubTexture(const size_t& subTexName);
 
+private:
+    void upload(unsigned char* image, const TextureParams& params);
+
 public:
     int mWidth = 0;
     int mHeight = 0;
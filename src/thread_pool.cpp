@@ -0,0 +1,90 @@
+#include "thread_pool.h"
+
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;
+
+    return instance;
+}
+
+ThreadPool::ThreadPool() {
+    // Один поток остаётся вызывающему
+    const unsigned hardware = std::thread::hardware_concurrency();
+    const unsigned workers = hardware > 1 ? hardware - 1 : 0;
+    for (unsigned i = 0; i < workers; ++i) mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    for (std::thread& worker : mWorkers) worker.join();
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& task) {
+    if (count == 0) return;
+    if (mWorkers.empty() || count == 1) {
+        for (uint32_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    {
+        // Опоздавший поток прошлого цикла может ещё читать mNext и mCount - ждём его выхода
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this] { return mBusy == 0; });
+        mTask = &task;
+        mCount = count;
+        mNext.store(0, std::memory_order_relaxed);
+        mFinished = 0;
+        ++mGeneration;
+    }
+    mWake.notify_all();
+
+    const uint32_t done = runTasks(task, count);
+
+    // Ждём и выполнения всех задач, и выхода опоздавших потоков из runTasks:
+    // после этого task можно разрушать, а состояние - готовить к следующему циклу
+    std::unique_lock<std::mutex> lock(mMutex);
+    mFinished += done;
+    mDone.wait(lock, [this] { return mFinished == mCount && mBusy == 0; });
+    mTask = nullptr;
+}
+
+uint32_t ThreadPool::threadCount() const {
+    return static_cast<uint32_t>(mWorkers.size()) + 1;
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seen = 0;
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mWake.wait(lock, [&] { return mStop || mGeneration != seen; });
+        if (mStop) return;
+        seen = mGeneration;
+        // Цикл уже завершён вызывающим - задач нет, а mTask указывает в никуда
+        if (!mTask) continue;
+        const std::function<void(uint32_t)>& task = *mTask;
+        const uint32_t count = mCount;
+        ++mBusy;
+        lock.unlock();
+
+        const uint32_t done = runTasks(task, count);
+
+        lock.lock();
+        mFinished += done;
+        --mBusy;
+        if (mBusy == 0) mDone.notify_all();
+    }
+}
+
+uint32_t ThreadPool::runTasks(const std::function<void(uint32_t)>& task, uint32_t count) {
+    uint32_t done = 0;
+    for (;;) {
+        const uint32_t index = mNext.fetch_add(1, std::memory_order_relaxed);
+        if (index >= count) break;
+        task(index);
+        ++done;
+    }
+    return done;
+}
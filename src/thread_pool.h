@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков для параллельных циклов по кадру (растеризация
+// окклюдеров, распределение источников по кластерам). Вызывающий поток
+// тоже берёт задачи, поэтому без рабочих потоков всё выполнится на нём.
+class ThreadPool {
+public:
+    static ThreadPool& getInstance();
+
+    ~ThreadPool();
+
+    // Вызывает task(i) для каждого i из [0, count) и возвращается, когда все вызовы
+    // завершены. Из task новый parallelFor запускать нельзя
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+    // Рабочие потоки плюс вызывающий
+    uint32_t threadCount() const;
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    ThreadPool();
+
+    void workerLoop();
+
+    // Выполняет задачи текущего цикла, пока они есть; возвращает число выполненных.
+    // task и count - снимок, сделанный под mMutex
+    uint32_t runTasks(const std::function<void(uint32_t)>& task, uint32_t count);
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+
+    // Меняются под mMutex и только при mBusy == 0: parallelFor ждёт выхода всех
+    // рабочих потоков из runTasks, прежде чем публиковать новый цикл
+    const std::function<void(uint32_t)>* mTask = nullptr;
+    uint32_t mCount = 0;
+    uint64_t mGeneration = 0;
+    bool mStop = false;
+
+    std::atomic<uint32_t> mNext{ 0 };
+    uint32_t mFinished = 0;
+    uint32_t mBusy = 0;
+};
@@ -0,0 +1,138 @@
+// Упаковщик ресурсов: собирает файлы каталога в один пакет формата resource_pack.h.
+//   indiv3_packer <output.pak> <root> [<root> ...]
+// Пути внутри пакета записываются относительно текущего каталога через '/',
+// например res/meshes/lamp.obj, - ровно так, как их запрашивает ResourceManager.
+#include "resource_pack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct SourceFile {
+    std::string name;
+    fs::path path;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+};
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static void collect(const fs::path& root, const fs::path& output, std::vector<SourceFile>& files) {
+    auto add = [&](const fs::path& path) {
+        if (fs::exists(output) && fs::equivalent(path, output)) return;
+        SourceFile file;
+        file.name = path.lexically_normal().generic_string();
+        file.path = path;
+        file.size = fs::file_size(path);
+        files.push_back(std::move(file));
+    };
+
+    if (fs::is_regular_file(root)) {
+        add(root);
+        return;
+    }
+    for (const auto& item : fs::recursive_directory_iterator(root)) {
+        if (item.is_regular_file()) add(item.path());
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.pak> <root> [<root> ...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const fs::path output = argv[1];
+
+    std::vector<SourceFile> files;
+    try {
+        for (int i = 2; i < argc; ++i) collect(argv[i], output, files);
+    }
+    catch (const fs::filesystem_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::sort(files.begin(), files.end(), [](const SourceFile& a, const SourceFile& b) { return a.name < b.name; });
+    files.erase(std::unique(files.begin(), files.end(),
+        [](const SourceFile& a, const SourceFile& b) { return a.name == b.name; }), files.end());
+
+    // Таблица заполнена не больше чем наполовину - короткие цепочки проб
+    uint32_t tableSize = 16;
+    while (tableSize < files.size() * 2) tableSize *= 2;
+
+    std::string names;
+    std::vector<PackEntry> table(tableSize);
+    std::memset(table.data(), 0, table.size() * sizeof(PackEntry));
+
+    PackHeader header;
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(files.size());
+    header.tableSize = tableSize;
+    header.tableOffset = sizeof(PackHeader);
+    header.namesOffset = header.tableOffset + uint64_t(tableSize) * sizeof(PackEntry);
+
+    uint64_t namesSize = 0;
+    for (const auto& file : files) namesSize += file.name.size();
+
+    uint64_t offset = alignUp(header.namesOffset + namesSize, PACK_ALIGNMENT);
+    for (auto& file : files) {
+        file.offset = offset;
+        offset = alignUp(offset + file.size, PACK_ALIGNMENT);
+
+        PackEntry entry;
+        entry.hash = packPathHash(file.name);
+        entry.offset = file.offset;
+        entry.size = file.size;
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(file.name.size());
+        names += file.name;
+
+        uint32_t slot = static_cast<uint32_t>(entry.hash) & (tableSize - 1);
+        while (table[slot].hash != 0) slot = (slot + 1) & (tableSize - 1);
+        table[slot] = entry;
+    }
+    // Последний файл тоже дополняется до границы, размер пакета кратен PACK_ALIGNMENT
+    header.fileSize = offset;
+
+    std::ofstream out(output, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: could not open '" << output.string() << "' for writing" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::vector<char> padding(PACK_ALIGNMENT, 0);
+    auto padTo = [&](uint64_t position) {
+        const uint64_t current = static_cast<uint64_t>(out.tellp());
+        if (position > current) out.write(padding.data(), static_cast<std::streamsize>(position - current));
+    };
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(PackEntry)));
+    out.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+    std::vector<char> buffer;
+    for (const auto& file : files) {
+        padTo(file.offset);
+        std::ifstream in(file.path, std::ios::binary);
+        buffer.resize(static_cast<size_t>(file.size));
+        if (!in.read(buffer.data(), static_cast<std::streamsize>(file.size))) {
+            std::cerr << "Error: could not read '" << file.path.string() << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    padTo(header.fileSize);
+
+    if (!out) {
+        std::cerr << "Error: failed to write '" << output.string() << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << output.string() << ": " << files.size() << " files, " << header.fileSize << " bytes" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+// Генератор списка uniform-переменных, объявленных в шейдерах.
+//   indiv3_uniformgen <output.h> <shader.glsl> [<shader.glsl> ...]
+// Результат - заголовок с constexpr-таблицей хешей, имён и типов. По нему
+// UniformId<"name"_hash> проверяет имя (и тип значения) ещё при компиляции.
+//
+// Разбор упрощённый, но достаточный для наших шейдеров: учитываются
+// #define с числами (размеры массивов), структуры, массивы структур и
+// uniform struct { ... } name. Члены uniform-блоков пропускаются - у них нет
+// собственных расположений. Ветки #if/#ifdef не вычисляются: в список попадают
+// uniform-переменные всех перестановок шейдера.
+#include "hash.h"
+
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Member {
+    std::string type;
+    std::string name;
+    int arraySize = 0;
+};
+
+struct Declared {
+    std::string name;
+    std::string type;
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string& source) { tokenize(source); }
+
+    void parse(std::vector<Declared>& out) {
+        while (mPos < mTokens.size()) {
+            const std::string& token = mTokens[mPos];
+            if (token == "struct") {
+                ++mPos;
+                const std::string name = next();
+                mStructs[name] = parseMembers();
+                skipPast(";");
+            }
+            else if (token == "uniform") {
+                ++mPos;
+                parseUniform(out);
+            }
+            else if (token == "{") {
+                skipBlock();
+            }
+            else {
+                ++mPos;
+            }
+        }
+    }
+
+private:
+    std::vector<std::string> mTokens;
+    size_t mPos = 0;
+    std::map<std::string, std::string> mDefines;
+    std::map<std::string, std::vector<Member>> mStructs;
+
+    void tokenize(const std::string& source) {
+        size_t i = 0;
+        while (i < source.size()) {
+            const char c = source[i];
+            if (c == '/' && i + 1 < source.size() && source[i + 1] == '/') {
+                while (i < source.size() && source[i] != '\n') ++i;
+            }
+            else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*') {
+                const size_t end = source.find("*/", i + 2);
+                i = (end == std::string::npos) ? source.size() : end + 2;
+            }
+            else if (c == '#') {
+                const size_t end = source.find('\n', i);
+                std::istringstream line(source.substr(i + 1, end == std::string::npos ? std::string::npos : end - i - 1));
+                std::string directive, name, value;
+                line >> directive >> name >> value;
+                if (directive == "define" && !name.empty() && !value.empty()) mDefines[name] = value;
+                i = (end == std::string::npos) ? source.size() : end + 1;
+            }
+            else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
+                const size_t start = i;
+                while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) ++i;
+                mTokens.push_back(source.substr(start, i - start));
+            }
+            else if (std::isspace(static_cast<unsigned char>(c))) {
+                ++i;
+            }
+            else {
+                mTokens.emplace_back(1, c);
+                ++i;
+            }
+        }
+    }
+
+    std::string next() {
+        return mPos < mTokens.size() ? mTokens[mPos++] : std::string();
+    }
+
+    bool accept(const char* token) {
+        if (mPos < mTokens.size() && mTokens[mPos] == token) {
+            ++mPos;
+            return true;
+        }
+        return false;
+    }
+
+    void skipPast(const char* token) {
+        while (mPos < mTokens.size() && mTokens[mPos++] != token) {}
+    }
+
+    void skipBlock() {
+        int depth = 0;
+        do {
+            if (mTokens[mPos] == "{") ++depth;
+            else if (mTokens[mPos] == "}") --depth;
+            ++mPos;
+        } while (mPos < mTokens.size() && depth > 0);
+    }
+
+    int parseArraySize() {
+        if (!accept("[")) return 0;
+        std::string size = next();
+        auto define = mDefines.find(size);
+        if (define != mDefines.end()) size = define->second;
+        skipPast("]");
+        try {
+            return std::stoi(size);
+        }
+        catch (const std::exception&) {
+            return 0;
+        }
+    }
+
+    static bool isQualifier(const std::string& token) {
+        static const std::set<std::string> qualifiers = { "highp", "mediump", "lowp", "flat", "smooth", "noperspective" };
+        return qualifiers.count(token) != 0;
+    }
+
+    std::vector<Member> parseMembers() {
+        std::vector<Member> members;
+        if (!accept("{")) return members;
+        while (mPos < mTokens.size() && !accept("}")) {
+            while (isQualifier(mTokens[mPos])) ++mPos;
+            const std::string type = next();
+            do {
+                Member member;
+                member.type = type;
+                member.name = next();
+                member.arraySize = parseArraySize();
+                members.push_back(member);
+            } while (accept(","));
+            skipPast(";");
+        }
+        return members;
+    }
+
+    void expand(const std::string& type, const std::string& name, int arraySize, std::vector<Declared>& out) {
+        auto structType = mStructs.find(type);
+        if (structType == mStructs.end()) {
+            out.push_back({ name, type });
+            for (int i = 0; i < arraySize; ++i) out.push_back({ name + "[" + std::to_string(i) + "]", type });
+            return;
+        }
+        const std::vector<Member> members = structType->second;
+        auto expandMembers = [&](const std::string& prefix) {
+            for (const Member& member : members) expand(member.type, prefix + "." + member.name, member.arraySize, out);
+        };
+        if (arraySize == 0) expandMembers(name);
+        for (int i = 0; i < arraySize; ++i) expandMembers(name + "[" + std::to_string(i) + "]");
+    }
+
+    void parseUniform(std::vector<Declared>& out) {
+        while (mPos < mTokens.size() && isQualifier(mTokens[mPos])) ++mPos;
+
+        if (accept("struct")) {
+            const std::string type = next();
+            mStructs[type] = parseMembers();
+            do {
+                const std::string name = next();
+                expand(type, name, parseArraySize(), out);
+            } while (accept(","));
+            skipPast(";");
+            return;
+        }
+
+        const std::string type = next();
+        if (mPos < mTokens.size() && mTokens[mPos] == "{") {
+            // uniform-блок: его члены не являются отдельными uniform-переменными
+            skipBlock();
+            skipPast(";");
+            return;
+        }
+        do {
+            const std::string name = next();
+            expand(type, name, parseArraySize(), out);
+        } while (accept(","));
+        skipPast(";");
+    }
+};
+
+// Тип GL, которым значение задаётся через glUniform*. Сэмплеры и bool задаются как int.
+static uint32_t glTypeOf(const std::string& type) {
+    static const std::map<std::string, uint32_t> types = {
+        { "float", 0x1406 }, { "int", 0x1404 }, { "uint", 0x1405 }, { "bool", 0x1404 },
+        { "vec2", 0x8B50 }, { "vec3", 0x8B51 }, { "vec4", 0x8B52 },
+        { "mat3", 0x8B5B }, { "mat4", 0x8B5C },
+    };
+    auto it = types.find(type);
+    if (it != types.end()) return it->second;
+    if (type.find("sampler") != std::string::npos || type.find("image") != std::string::npos) return 0x1404;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <output.h> <shader.glsl> [<shader.glsl> ...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::map<std::string, std::string> uniforms;
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream input(argv[i], std::ios::binary);
+        if (!input.is_open()) {
+            std::cerr << "Error: could not open '" << argv[i] << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::stringstream source;
+        source << input.rdbuf();
+
+        std::vector<Declared> declared;
+        Parser(source.str()).parse(declared);
+        for (const Declared& uniform : declared) {
+            auto it = uniforms.find(uniform.name);
+            if (it != uniforms.end() && it->second != uniform.type) {
+                std::cerr << "Error: uniform '" << uniform.name << "' declared as both "
+                    << it->second << " and " << uniform.type << std::endl;
+                return EXIT_FAILURE;
+            }
+            uniforms[uniform.name] = uniform.type;
+        }
+    }
+
+    std::map<uint64_t, std::string> hashes;
+    for (const auto& uniform : uniforms) {
+        const uint64_t hash = fnv1a64(uniform.first);
+        if (!hashes.emplace(hash, uniform.first).second) {
+            std::cerr << "Error: hash collision between '" << uniform.first << "' and '" << hashes[hash] << "'" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ostringstream out;
+    out << "#pragma once\n"
+        << "// Сгенерировано indiv3_uniformgen, не редактировать.\n"
+        << "#include <cstddef>\n"
+        << "#include <cstdint>\n\n"
+        << "namespace shader_uniforms {\n\n"
+        << "constexpr size_t count = " << uniforms.size() << ";\n\n"
+        << "constexpr uint64_t hashes[count + 1] = {\n";
+    for (const auto& uniform : uniforms) {
+        out << "    0x" << std::hex << std::setw(16) << std::setfill('0') << fnv1a64(uniform.first) << std::dec
+            << "ull, // " << uniform.first << "\n";
+    }
+    out << "    0\n};\n\n"
+        << "constexpr uint32_t types[count + 1] = {\n";
+    for (const auto& uniform : uniforms) {
+        out << "    0x" << std::hex << glTypeOf(uniform.second) << std::dec << ", // " << uniform.second << "\n";
+    }
+    out << "    0\n};\n\n"
+        << "constexpr const char* names[count + 1] = {\n";
+    for (const auto& uniform : uniforms) out << "    \"" << uniform.first << "\",\n";
+    out << "    nullptr\n};\n\n"
+        << "constexpr int indexOf(uint64_t hash) {\n"
+        << "    for (size_t i = 0; i < count; ++i) {\n"
+        << "        if (hashes[i] == hash) return static_cast<int>(i);\n"
+        << "    }\n"
+        << "    return -1;\n"
+        << "}\n\n"
+        << "}\n";
+
+    // Не трогаем файл, если содержимое не изменилось, - иначе пересобирается всё
+    const std::string text = out.str();
+    {
+        std::ifstream existing(argv[1], std::ios::binary);
+        std::stringstream current;
+        current << existing.rdbuf();
+        if (existing.is_open() && current.str() == text) return EXIT_SUCCESS;
+    }
+    std::ofstream output(argv[1], std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        std::cerr << "Error: could not write '" << argv[1] << "'" << std::endl;
+        return EXIT_FAILURE;
+    }
+    output << text;
+    return EXIT_SUCCESS;
+}